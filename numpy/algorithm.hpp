@@ -1,12 +1,15 @@
 #pragma once
 
 #include <type_traits>
+#include <limits>
 
 namespace numpy {
 
+  // only for comparison functions, an integer being the axis of the ndarray overloads
   template <class ArrayLike, class CompFunc>
-  auto max(const ArrayLike& arr, CompFunc is_smaller_than) -> typename std::remove_reference<decltype(*arr.begin())>::type {
-    using T = typename std::remove_reference<decltype(*arr.begin())>::type;
+  auto max(const ArrayLike& arr, CompFunc is_smaller_than)
+    -> std::decay_t<decltype(void(is_smaller_than(*arr.begin(), *arr.begin())), *arr.begin())> {
+    using T = std::decay_t<decltype(*arr.begin())>;
     T maxval = *arr.begin();
     for (const auto e : arr)
       if (is_smaller_than(maxval, e))
@@ -15,7 +18,7 @@ namespace numpy {
   }
 
   template <class ArrayLike>
-  auto max(const ArrayLike& arr) -> decltype(max(arr, 0)) {
+  auto max(const ArrayLike& arr) -> std::decay_t<decltype(*arr.begin())> {
     return max(arr, [](auto small, auto large){return small < large;});
   }
   
@@ -23,5 +26,333 @@ namespace numpy {
   auto min(const ArrayLike& arr) -> decltype(max(arr)) {
     return max(arr, [](auto small, auto large){return small > large;});
   }
-  
+
+  namespace _reduction {
+
+    // better(x, y) tells whether x replaces y as the maximum or the minimum. NaN wins as in
+    // NumPy's max and argmax, or loses to any number as in nanmax and nanargmax.
+    template <bool maximum_, bool ignore_nan_>
+    struct _better {
+      static constexpr bool maximum = maximum_, ignore_nan = ignore_nan_;
+
+      template <class Dtype>
+      bool operator()(Dtype x, Dtype y) const {
+	auto strictly = maximum ? y < x : x < y;
+	if constexpr (ignore_nan)
+	  return strictly or y != y;
+	else
+	  return strictly or (x != x and y == y);
+      }
+    };
+
+    constexpr intp extremum_lanes = 32; // compilers do not vectorize the selections on fewer
+
+    template <class Dtype, class Better>
+    Dtype _best_run(const Dtype* p, intp n, intp stride, Better) {
+      // The best of p[0], p[stride], ..., p[(n-1)*stride], n > 0, in independent lanes.
+      // NaNs are tracked in lanes of their own, so that the selections compile to vector
+      // max or min instructions.
+      constexpr bool maximum = Better::maximum, ignore_nan = Better::ignore_nan;
+      constexpr bool has_nan = std::numeric_limits<Dtype>::has_quiet_NaN;
+      constexpr Dtype worst = std::numeric_limits<Dtype>::has_infinity
+	? (maximum ? -std::numeric_limits<Dtype>::infinity() : std::numeric_limits<Dtype>::infinity())
+	: (maximum ? std::numeric_limits<Dtype>::lowest() : std::numeric_limits<Dtype>::max());
+      auto select = [](Dtype x, Dtype y) { return (maximum ? x < y : y < x) ? y : x; };
+      Dtype r[extremum_lanes], q[extremum_lanes]; // q: a NaN seen, or a number if `ignore_nan`
+      std::fill(r, r + extremum_lanes, worst);
+      std::fill(q, q + extremum_lanes, ignore_nan ? std::numeric_limits<Dtype>::quiet_NaN() : Dtype(0));
+      auto update = [&](intp l, Dtype x) {
+	r[l] = select(r[l], x);
+	if constexpr (has_nan)
+	  q[l] = (ignore_nan ? x == x : x != x) ? x : q[l];
+      };
+      intp i = 0;
+      for (; i+extremum_lanes<=n; i+=extremum_lanes)
+	for (intp l=0; l<extremum_lanes; l++)
+	  update(l, p[(i + l)*stride]);
+      for (; i<n; i++)
+	update(0, p[i*stride]);
+      if constexpr (has_nan) {
+	bool nan = std::all_of(q, q + extremum_lanes, [](Dtype x) { return x != x; });
+	if (ignore_nan ? nan : std::any_of(q, q + extremum_lanes, [](Dtype x) { return x != x; }))
+	  return std::numeric_limits<Dtype>::quiet_NaN();
+      }
+      return std::accumulate(r + 1, r + extremum_lanes, r[0], select);
+    }
+
+    template <class Dtype, class Better>
+    std::pair<Dtype, intp> _arg_run(const Dtype* p, intp n, intp stride, Better better) {
+      // the best element and its first index: the value is found first, which vectorizes,
+      // then searched for. Short runs are scanned once.
+      if (n < 4 * extremum_lanes) {
+	// the NaNs are dealt with apart, which keeps the comparisons predictable
+	intp i = 0;
+	if constexpr (Better::ignore_nan)
+	  while (i < n - 1 and p[i*stride] != p[i*stride])
+	    i++;
+	auto v = p[i*stride];
+	auto k = i;
+	if (not Better::ignore_nan and v != v)
+	  return {v, k};
+	for (i++; i<n; i++) {
+	  auto x = p[i*stride];
+	  if (x != x) {
+	    if (Better::ignore_nan)
+	      continue;
+	    return {x, i};
+	  }
+	  if (Better::maximum ? v < x : x < v) {
+	    v = x;
+	    k = i;
+	  }
+	}
+	return {v, k};
+      }
+      auto v = _best_run(p, n, stride, better);
+      intp i = 0;
+      if (v != v)
+	while (p[i*stride] == p[i*stride])
+	  i++;
+      else
+	while (p[i*stride] != v)
+	  i++;
+      return {v, i};
+    }
+
+    template <class Dtype, class Better>
+    Dtype _extremum(const ndarray<Dtype>& a, int workers, Better better, const char* name) {
+      // max or min by chunks on the raw memory (see _map_chunks)
+      if (a.size() == 0)
+	throw std::invalid_argument(std::string("ValueError: zero-size array to reduction operation ") + name
+				    + " which has no identity");
+      auto partial = _map_chunks<Dtype>(a, workers, [&](const Dtype* p, intp n, intp stride) {
+	return _best_run(p, n, stride, better);
+      });
+      return _best_run(partial.data(), partial.size(), intp(1), better);
+    }
+
+    template <class Dtype, class Better>
+    std::pair<Dtype, intp> _arg_extremum(const ndarray<Dtype>& a, Better better, const char* name) {
+      // the best element and its index in the flattened array
+      if (a.size() == 0)
+	throw std::invalid_argument(std::string("ValueError: attempt to get ") + name + " of an empty sequence");
+      std::pair<Dtype, intp> ret = {a.data()[0], 0};
+      intp start = 0;
+      _for_each_run(a, [&](const Dtype* p, intp n, intp stride) {
+	auto [v, k] = _arg_run(p, n, stride, better);
+	if (better(v, ret.first))
+	  ret = {v, start + k};
+	start += n;
+      });
+      return ret;
+    }
+
+    template <class Dtype, class Better>
+    std::pair<ndarray<Dtype>, ndarray<intp>> _arg_extremum(const ndarray<Dtype>& a, axis_type axis, bool keepdims,
+							   Better better, const char* name) {
+      // The best elements along `axis` and their indices. Each output is found along its fiber
+      // when `axis` is the innermost one; otherwise tiles of consecutive outputs are updated
+      // row by row, so that memory is read in its order.
+      axis = _normalize_axes({axis}, a.ndim())[0];
+      if (a.shape(axis) == 0)
+	throw std::invalid_argument(std::string("ValueError: attempt to get ") + name + " of an empty sequence");
+      auto shape = a.shape();
+      if (keepdims)
+	shape[axis] = 1;
+      else
+	shape.erase(shape.begin() + axis);
+      auto values = empty<Dtype>(shape);
+      auto indices = empty<intp>(shape);
+      if (values.size() == 0)
+	return {values, indices};
+      auto n = a.shape(axis), stride = a.strides()[axis];
+      _runs cols(a.shape(), a.strides(), _complement_axes({axis}, a.ndim()));
+      auto v = values.data();
+      auto k = indices.data();
+      if (std::abs(stride) <= std::abs(cols.stride) or cols.n == 1) {
+	for (auto col : cols.offsets)
+	  for (intp j=0; j<cols.n; j++)
+	    std::tie(*v++, *k++) = _arg_run(a.data() + col + j*cols.stride, n, stride, better);
+	return {values, indices};
+      }
+      for (auto col : cols.offsets)
+	for (intp j0=0; j0<cols.n; j0+=axis_tile) {
+	  auto m = std::min(axis_tile, cols.n - j0);
+	  auto p = a.data() + col + j0*cols.stride;
+	  for (intp j=0; j<m; j++) {
+	    v[j] = p[j*cols.stride];
+	    k[j] = 0;
+	  }
+	  for (intp i=1; i<n; i++) {
+	    auto row = p + i*stride;
+	    for (intp j=0; j<m; j++) {
+	      auto x = row[j*cols.stride];
+	      bool c = better(x, v[j]);
+	      v[j] = c ? x : v[j];
+	      k[j] = c ? i : k[j];
+	    }
+	  }
+	  v += m;
+	  k += m;
+	}
+      return {values, indices};
+    }
+
+    template <class Dtype>
+    void _check_all_nan(const ndarray<Dtype>& values) {
+      for (auto p=values.data(), end=p + values.size(); p!=end; ++p)
+	if (*p != *p)
+	  throw std::invalid_argument("ValueError: All-NaN slice encountered");
+    }
+
+    using _max = _better<true, false>;
+    using _min = _better<false, false>;
+    using _nanmax = _better<true, true>;
+    using _nanmin = _better<false, true>;
+
+  }
+
+  // Maxima and minima as NumPy's: NaN is returned if there is any, unless the nan* functions are
+  // used, which ignore them. Ties are resolved by the first index.
+
+  template <class Dtype>
+  Dtype max(const ndarray<Dtype>& a, python::NoneType axis=python::None, int workers=-1) {
+    // large arrays are reduced by `workers` threads (-1 for all the CPUs), as sum
+    return _reduction::_extremum(a, workers, _reduction::_max(), "maximum");
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> max(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return _reduction::_arg_extremum(a, axis, keepdims, _reduction::_max(), "maximum").first;
+  }
+
+  template <class Dtype>
+  Dtype min(const ndarray<Dtype>& a, python::NoneType axis=python::None, int workers=-1) {
+    return _reduction::_extremum(a, workers, _reduction::_min(), "minimum");
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> min(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return _reduction::_arg_extremum(a, axis, keepdims, _reduction::_min(), "minimum").first;
+  }
+
+  template <class Dtype>
+  Dtype amax(const ndarray<Dtype>& a) {
+    return max(a);
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> amax(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return max(a, axis, keepdims);
+  }
+
+  template <class Dtype>
+  Dtype amin(const ndarray<Dtype>& a) {
+    return min(a);
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> amin(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return min(a, axis, keepdims);
+  }
+
+  template <class Dtype>
+  Dtype ptp(const ndarray<Dtype>& a, python::NoneType axis=python::None, int workers=-1) {
+    // max(a) - min(a), both found in a single pass over the chunks
+    if (a.size() == 0)
+      throw std::invalid_argument("ValueError: zero-size array to reduction operation maximum which has no identity");
+    auto partial = _reduction::_map_chunks<std::pair<Dtype, Dtype>>(a, workers, [](const Dtype* p, intp n, intp stride) {
+      return std::make_pair(_reduction::_best_run(p, n, stride, _reduction::_max()),
+			    _reduction::_best_run(p, n, stride, _reduction::_min()));
+    });
+    auto hi = partial[0].first, lo = partial[0].second;
+    for (auto [h, l] : partial) {
+      hi = _reduction::_max()(h, hi) ? h : hi;
+      lo = _reduction::_min()(l, lo) ? l : lo;
+    }
+    return hi - lo;
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> ptp(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    auto ret = amax(a, axis, keepdims);
+    auto lo = amin(a, axis, keepdims);
+    for (intp i=0; i<ret.size(); i++)
+      ret.data()[i] -= lo.data()[i];
+    return ret;
+  }
+
+  template <class Dtype>
+  intp argmax(const ndarray<Dtype>& a) {
+    // the index in the flattened array
+    return _reduction::_arg_extremum(a, _reduction::_max(), "argmax").second;
+  }
+
+  template <class Dtype>
+  ndarray<intp> argmax(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return _reduction::_arg_extremum(a, axis, keepdims, _reduction::_max(), "argmax").second;
+  }
+
+  template <class Dtype>
+  intp argmin(const ndarray<Dtype>& a) {
+    return _reduction::_arg_extremum(a, _reduction::_min(), "argmin").second;
+  }
+
+  template <class Dtype>
+  ndarray<intp> argmin(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return _reduction::_arg_extremum(a, axis, keepdims, _reduction::_min(), "argmin").second;
+  }
+
+  template <class Dtype>
+  Dtype nanmax(const ndarray<Dtype>& a, python::NoneType axis=python::None, int workers=-1) {
+    // NaN only if all the elements are
+    return _reduction::_extremum(a, workers, _reduction::_nanmax(), "maximum");
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> nanmax(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return _reduction::_arg_extremum(a, axis, keepdims, _reduction::_nanmax(), "nanmax").first;
+  }
+
+  template <class Dtype>
+  Dtype nanmin(const ndarray<Dtype>& a, python::NoneType axis=python::None, int workers=-1) {
+    return _reduction::_extremum(a, workers, _reduction::_nanmin(), "minimum");
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> nanmin(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    return _reduction::_arg_extremum(a, axis, keepdims, _reduction::_nanmin(), "nanmin").first;
+  }
+
+  template <class Dtype>
+  intp nanargmax(const ndarray<Dtype>& a) {
+    // raises ValueError if all the elements are NaN
+    auto [value, index] = _reduction::_arg_extremum(a, _reduction::_nanmax(), "nanargmax");
+    if (value != value)
+      throw std::invalid_argument("ValueError: All-NaN slice encountered");
+    return index;
+  }
+
+  template <class Dtype>
+  ndarray<intp> nanargmax(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    auto [values, indices] = _reduction::_arg_extremum(a, axis, keepdims, _reduction::_nanmax(), "nanargmax");
+    _reduction::_check_all_nan(values);
+    return indices;
+  }
+
+  template <class Dtype>
+  intp nanargmin(const ndarray<Dtype>& a) {
+    auto [value, index] = _reduction::_arg_extremum(a, _reduction::_nanmin(), "nanargmin");
+    if (value != value)
+      throw std::invalid_argument("ValueError: All-NaN slice encountered");
+    return index;
+  }
+
+  template <class Dtype>
+  ndarray<intp> nanargmin(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false) {
+    auto [values, indices] = _reduction::_arg_extremum(a, axis, keepdims, _reduction::_nanmin(), "nanargmin");
+    _reduction::_check_all_nan(values);
+    return indices;
+  }
+
 }
@@ -13,51 +13,843 @@ namespace numpy {
   template <class Dtype> ndarray<Dtype> zeros(const shape_type& shape);
   template <class... Dtype> std::tuple<ndarray<Dtype>...> at_least_2d(const ndarray<Dtype>&... arys);
   
+  inline bool _merge_axes(const shape_type& shape, const stride_type& stride,
+			  const axes_type& axes, intp& merged_stride) {
+    // Checks if the given axes (in this order) can be traversed as a single flat axis
+    // without copying. If so, its stride is stored in `merged_stride`.
+    bool first = true;
+    intp expected = 0;
+    merged_stride = 1;
+    for (auto itr = axes.rbegin(); itr != axes.rend(); ++itr) {
+      if (shape[*itr] == 1)
+	continue;
+      if (first) {
+	merged_stride = stride[*itr];
+	first = false;
+      } else if (stride[*itr] != expected) {
+	return false;
+      }
+      expected = stride[*itr] * shape[*itr];
+    }
+    return true;
+  }
+
+  inline axes_type _normalize_axes(const axes_type& axes, dim_type ndim) {
+    axes_type ret(axes);
+    for (auto& ax : ret) {
+      if (ax < -ndim or ax >= ndim)
+	throw std::out_of_range("AxisError: axis " + python::str(ax)
+				+ " is out of bounds for array of dimension " + python::str(ndim));
+      if (ax < 0)
+	ax += ndim;
+    }
+    return ret;
+  }
+
+  inline axes_type _complement_axes(const axes_type& axes, dim_type ndim) {
+    axes_type ret;
+    for (axis_type ax=0; ax<ndim; ax++)
+      if (std::find(axes.begin(), axes.end(), ax) == axes.end())
+	ret.push_back(ax);
+    return ret;
+  }
+  
+  enum class summation {
+    pairwise, // as NumPy: fast, with an error growing as O(log n)
+    neumaier  // compensated: about twice slower, with an error independent of n
+  };
+
+  namespace _reduction {
+
+    constexpr intp pairwise_block = 128;
+
+    struct _identity {
+      template <class T> T operator()(T x) const { return x; }
+    };
+
+    template <bool unit_stride, class T, class Input, class Transform>
+    T _pairwise_sum(const Input* a, intp n, intp stride, Transform f) {
+      // NumPy's pairwise summation of f(a_i): blocks of up to 128 elements are added by 8
+      // independent accumulators, and the block sums are added along a balanced binary tree.
+      if constexpr (unit_stride)
+	stride = 1;
+      if (n < 8) {
+	T s = T(0);
+	for (intp i=0; i<n; i++)
+	  s += f(a[i*stride]);
+	return s;
+      }
+      if (n <= pairwise_block) {
+	T r[8];
+	for (intp l=0; l<8; l++)
+	  r[l] = f(a[l*stride]);
+	intp i = 8;
+	for (; i+8<=n; i+=8)
+	  for (intp l=0; l<8; l++)
+	    r[l] += f(a[(i + l)*stride]);
+	auto s = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+	for (; i<n; i++)
+	  s += f(a[i*stride]);
+	return s;
+      }
+      auto n2 = n / 2;
+      n2 -= n2 % 8;
+      return _pairwise_sum<unit_stride, T>(a, n2, stride, f) + _pairwise_sum<unit_stride, T>(a + n2*stride, n - n2, stride, f);
+    }
+
+    template <class T, class Input, class Transform=_identity>
+    T pairwise_sum(const Input* a, intp n, intp stride, Transform f=Transform()) {
+      return stride == 1 ? _pairwise_sum<true, T>(a, n, stride, f) : _pairwise_sum<false, T>(a, n, stride, f);
+    }
+
+    template <class T>
+    struct neumaier_sum {
+      // Kahan-Babuska (Neumaier) compensated summation, run in 8 interleaved lanes so that the
+      // dependency chains overlap. Meant for floating-point types.
+      T s[8] = {}, c[8] = {};
+
+      static void _add(T& s, T& c, T x) {
+	auto t = s + x;
+	c += std::abs(s) >= std::abs(x) ? (s - t) + x : (x - t) + s;
+	s = t;
+      }
+
+      template <class Input, class Transform=_identity>
+      void add(const Input* a, intp n, intp stride, Transform f=Transform()) {
+	intp i = 0;
+	for (; i+8<=n; i+=8)
+	  for (intp l=0; l<8; l++)
+	    _add(s[l], c[l], f(a[(i + l)*stride]));
+	for (; i<n; i++)
+	  _add(s[0], c[0], f(a[i*stride]));
+      }
+
+      std::pair<T, T> partial() const {
+	// the sum and its correction, to be merged with other partial sums
+	T total = T(0), comp = T(0);
+	for (intp l=0; l<8; l++) {
+	  _add(total, comp, s[l]);
+	  comp += c[l];
+	}
+	return {total, comp};
+      }
+
+      T result() const {
+	auto [total, comp] = partial();
+	return total + comp;
+      }
+    };
+
+    template <class Function>
+    void _for_each_offset(const shape_type& shape, const stride_type& strides, dim_type begin, dim_type end, Function f) {
+      // f(offset) for every index of the axes begin, ..., end-1 in C order, the other ones being 0
+      for (auto d=begin; d<end; d++)
+	if (shape[d] == 0)
+	  return;
+      std::vector<intp> index(end - begin, 0);
+      intp offset = 0;
+      while (true) {
+	f(offset);
+	auto d = end - 1;
+	for (; d>=begin; d--) {
+	  offset += strides[d];
+	  if (++index[d - begin] < shape[d])
+	    break;
+	  offset -= strides[d] * shape[d];
+	  index[d - begin] = 0;
+	}
+	if (d < begin)
+	  return;
+      }
+    }
+
+    template <class Dtype, class Function>
+    void _for_each_run(const ndarray<Dtype>& a, Function f) {
+      // f(pointer, length, stride) on runs of equally spaced elements covering `a` in C order:
+      // a single one if its axes merge, its rows otherwise
+      if (a.size() == 0)
+	return;
+      axes_type axes(a.ndim());
+      std::iota(axes.begin(), axes.end(), axis_type(0));
+      intp stride = 1;
+      if (a.ndim() <= 1 or _merge_axes(a.shape(), a.strides(), axes, stride)) {
+	f(a.data(), a.size(), a.ndim() == 0 ? intp(1) : a.ndim() == 1 ? a.strides()[0] : stride);
+	return;
+      }
+      auto last = a.ndim() - 1;
+      _for_each_offset(a.shape(), a.strides(), 0, last, [&](intp offset) {
+	f(a.data() + offset, a.shape(last), a.strides()[last]);
+      });
+    }
+
+    // Reductions of whole arrays are split into chunks of up to parallel_chunk consecutive
+    // elements of a run, at positions that depend on the array only. The chunks are reduced
+    // concurrently, and their results are combined in a fixed order, so that the result is
+    // bit-identical whatever the number of threads.
+    constexpr intp parallel_chunk = intp(1) << 16;
+    constexpr intp parallel_min_size = intp(1) << 20; // smaller arrays are reduced by one thread
+
+    template <class Dtype>
+    struct _chunk {
+      const Dtype* data;
+      intp n, stride;
+    };
+
+    template <class T, class Dtype, class Function>
+    std::vector<T> _map_chunks(const ndarray<Dtype>& a, int workers, Function f) {
+      // the results of f(pointer, length, stride) for the chunks of `a`, in order
+      std::vector<_chunk<Dtype>> chunks;
+      _for_each_run(a, [&](const Dtype* p, intp n, intp stride) {
+	for (intp i=0; i<n; i+=parallel_chunk)
+	  chunks.push_back({p + i*stride, std::min(parallel_chunk, n - i), stride});
+      });
+      std::vector<T> ret(chunks.size());
+      workers = a.size() < parallel_min_size ? 1 : _parallel::num_workers(workers);
+      // the tasks only schedule the chunks and do not change the results
+      intp n_tasks = std::min<intp>(chunks.size(), 4 * workers);
+      _parallel::parallel_for(n_tasks, workers, [&](intp t) {
+	for (auto i=chunks.size()*t/n_tasks; i<chunks.size()*(t + 1)/n_tasks; i++)
+	  ret[i] = f(chunks[i].data, chunks[i].n, chunks[i].stride);
+      });
+      return ret;
+    }
+
+    template <class T, class Dtype, class Transform=_identity>
+    T _sum(const ndarray<Dtype>& a, summation method, int workers, Transform f=Transform()) {
+      // the sum of f(a_i) as T
+      if constexpr (std::is_floating_point_v<T>) {
+	if (method == summation::neumaier) {
+	  auto partial = _map_chunks<std::pair<T, T>>(a, workers, [&](const Dtype* p, intp n, intp stride) {
+	    neumaier_sum<T> acc;
+	    acc.add(p, n, stride, f);
+	    return acc.partial();
+	  });
+	  T total = T(0), comp = T(0);
+	  for (auto [s, c] : partial) {
+	    neumaier_sum<T>::_add(total, comp, s);
+	    comp += c;
+	  }
+	  return total + comp;
+	}
+      }
+      auto partial = _map_chunks<T>(a, workers, [&](const Dtype* p, intp n, intp stride) {
+	return pairwise_sum<T>(p, n, stride, f);
+      });
+      return partial.size() == 1 ? partial[0] : pairwise_sum<T>(partial.data(), partial.size(), intp(1));
+    }
+
+    struct _runs {
+      // the elements of some axes of an array, as equally spaced runs of n elements starting at offsets
+      std::vector<intp> offsets;
+      intp n, stride;
+
+      _runs(const shape_type& shape, const stride_type& strides, const axes_type& axes) : n(1), stride(1) {
+	if (axes.empty() or _merge_axes(shape, strides, axes, stride)) {
+	  offsets = {0};
+	  for (auto ax : axes)
+	    n *= shape[ax];
+	  return;
+	}
+	shape_type sub_shape;
+	stride_type sub_strides;
+	for (auto ax : axes) {
+	  sub_shape.push_back(shape[ax]);
+	  sub_strides.push_back(strides[ax]);
+	}
+	n = sub_shape.back();
+	stride = sub_strides.back();
+	_for_each_offset(sub_shape, sub_strides, 0, sub_shape.size() - 1, [&](intp offset) {
+	  offsets.push_back(offset);
+	});
+      }
+
+      intp size() const { return offsets.size() * n; }
+      intp offset(intp i) const { return offsets[i / n] + (i % n) * stride; }
+    };
+
+    constexpr intp axis_tile = 2048; // outputs computed together when the reduced axes are not the innermost
+
+    template <class T, class Dtype, class Transform>
+    void _pairwise_rows(T* out, const Dtype* p, intp m, intp stride, const _runs& rows, intp begin, intp end,
+			T* scratch, Transform f) {
+      // out[j] = sum of f(p[j*stride + rows.offset(i)]) for j < m and begin <= i < end,
+      // adding the rows in blocks and the blocks pairwise, as _pairwise_sum does for elements
+      if (end - begin > pairwise_block) {
+	auto mid = begin + (end - begin) / 2;
+	_pairwise_rows(out, p, m, stride, rows, begin, mid, scratch, f);
+	_pairwise_rows(scratch, p, m, stride, rows, mid, end, scratch + m, f);
+	for (intp j=0; j<m; j++)
+	  out[j] += scratch[j];
+	return;
+      }
+      std::fill(out, out + m, T(0));
+      for (auto i=begin; i<end; i++) {
+	auto row = p + rows.offset(i);
+	if (stride == 1)
+	  for (intp j=0; j<m; j++)
+	    out[j] += f(row[j]);
+	else
+	  for (intp j=0; j<m; j++)
+	    out[j] += f(row[j*stride]);
+      }
+    }
+
+    template <class T, class Dtype, class Transform=_identity>
+    ndarray<T> _sum_axes(const ndarray<Dtype>& a, const axes_type& axes, bool keepdims, summation method,
+			 Transform f=Transform()) {
+      // The sums of f(a_i) over `axes`, straight from the raw memory. When the reduced axes are the
+      // innermost ones, each output is a pairwise (or compensated) sum along them. Otherwise tiles
+      // of consecutive outputs are accumulated row by row, so that memory is read in its order.
+      auto reduced = _normalize_axes(axes, a.ndim());
+      std::sort(reduced.begin(), reduced.end());
+      if (std::adjacent_find(reduced.begin(), reduced.end()) != reduced.end())
+	throw std::invalid_argument("ValueError: duplicate value in 'axis'");
+      auto kept = _complement_axes(reduced, a.ndim());
+      shape_type shape;
+      for (axis_type ax=0; ax<a.ndim(); ax++)
+	if (std::binary_search(reduced.begin(), reduced.end(), ax)) {
+	  if (keepdims)
+	    shape.push_back(1);
+	} else {
+	  shape.push_back(a.shape(ax));
+	}
+      auto out = empty<T>(shape);
+      if (out.size() == 0)
+	return out;
+      _runs rows(a.shape(), a.strides(), reduced), cols(a.shape(), a.strides(), kept);
+      auto out_ = out.data();
+      bool compensated = std::is_floating_point_v<T> and method == summation::neumaier;
+
+      if (rows.size() == 0) {
+	std::fill(out_, out_ + out.size(), T(0));
+      } else if (std::abs(rows.stride) <= std::abs(cols.stride) or cols.n == 1) {
+	std::vector<T> partial(rows.offsets.size());
+	for (auto col : cols.offsets)
+	  for (intp j=0; j<cols.n; j++) {
+	    auto p = a.data() + col + j*cols.stride;
+	    if (compensated) {
+	      neumaier_sum<T> acc;
+	      for (auto row : rows.offsets)
+		acc.add(p + row, rows.n, rows.stride, f);
+	      *out_++ = acc.result();
+	      continue;
+	    }
+	    for (std::size_t k=0; k<rows.offsets.size(); k++)
+	      partial[k] = pairwise_sum<T>(p + rows.offsets[k], rows.n, rows.stride, f);
+	    *out_++ = partial.size() == 1 ? partial[0] : pairwise_sum<T>(partial.data(), partial.size(), intp(1));
+	  }
+      } else {
+	intp depth = 1;
+	for (auto n=rows.size(); n>pairwise_block; n=(n + 1)/2)
+	  depth++;
+	std::vector<T> scratch(depth * axis_tile), comp(axis_tile);
+	for (auto col : cols.offsets)
+	  for (intp j0=0; j0<cols.n; j0+=axis_tile) {
+	    auto m = std::min(axis_tile, cols.n - j0);
+	    auto p = a.data() + col + j0*cols.stride;
+	    if (compensated) {
+	      std::fill(out_, out_ + m, T(0));
+	      std::fill(comp.begin(), comp.begin() + m, T(0));
+	      for (intp i=0; i<rows.size(); i++) {
+		auto row = p + rows.offset(i);
+		for (intp j=0; j<m; j++)
+		  neumaier_sum<T>::_add(out_[j], comp[j], f(row[j*cols.stride]));
+	      }
+	      for (intp j=0; j<m; j++)
+		out_[j] += comp[j];
+	    } else {
+	      _pairwise_rows(out_, p, m, cols.stride, rows, 0, rows.size(), scratch.data(), f);
+	    }
+	    out_ += m;
+	  }
+      }
+      return out;
+    }
+
+  }
+
+  template <class Dtype>
+  auto sum(const ndarray<Dtype>& a, summation method=summation::pairwise, int workers=-1) -> Dtype {
+    // The sum of all the elements, pairwise as NumPy or compensated, on the raw memory.
+    // Integers are added exactly in either case. Large arrays are reduced by `workers` threads
+    // (-1 for all the CPUs) with the same result for any number of them.
+    return _reduction::_sum<Dtype>(a, method, workers);
+  }
+
   template <class Dtype>
-  auto sum(const ndarray<Dtype>& a) -> Dtype {
-    return std::accumulate(a.begin(), a.end(), Dtype(0));
+  auto sum(const ndarray<Dtype>& a, const axes_type& axes, bool keepdims=false,
+	   summation method=summation::pairwise) -> ndarray<Dtype> {
+    // The sums over `axes`, which are kept with length 1 if `keepdims`.
+    return _reduction::_sum_axes<Dtype>(a, axes, keepdims, method);
   }
 
   template <class Dtype>
-  auto sum(const ndarray<Dtype>& a, axis_type axis) -> ndarray<Dtype> {
+  auto sum(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false,
+	   summation method=summation::pairwise) -> ndarray<Dtype> {
+    return _reduction::_sum_axes<Dtype>(a, {axis}, keepdims, method);
+  }
+
+  template <class Dtype, class BinaryOperation>
+  auto _fold_axis(const ndarray<Dtype>& a, axis_type axis, BinaryOperation op)
+    -> ndarray<std::remove_const_t<decltype(op(Dtype(), Dtype()))>> {
+    // op(...op(op(a_0, a_1), a_2)..., a_n-1) along `axis`, for ufunc.reduce
+    using OutputType = std::remove_const_t<decltype(op(Dtype(), Dtype()))>;
+    axis = _normalize_axes({axis}, a.ndim())[0];
     auto shape = a.shape();
     shape.erase(shape.begin() + axis);
-    auto out = zeros<Dtype>(shape);
+    auto out = empty<OutputType>(shape);
     auto tmp = utils::bring_axis_to_head(a, axis);
-    for (int i = 0; i<tmp.shape(0); i++)
-      out += tmp[i];
+    auto n = tmp.shape(0), stride = tmp.strides()[0];
+    if (n == 0)
+      throw std::invalid_argument("ValueError: zero-size array to reduction operation which has no identity");
+    auto out_ = out.data();
+    _reduction::_for_each_offset(tmp.shape(), tmp.strides(), 1, tmp.ndim(), [&](intp offset) {
+      auto p = tmp.data() + offset;
+      OutputType acc = p[0];
+      for (intp i=1; i<n; i++)
+	acc = op(acc, p[i*stride]);
+      *out_++ = acc;
+    });
     return out;
   }
 
-  template <class Dtype, class... Args>
-  auto mean(const ndarray<Dtype>& a, Args... args) -> decltype(sum(a, args...)) {
-    auto sum_ = sum(a, args...);
+  template <class Dtype>
+  auto mean(const ndarray<Dtype>& a, summation method=summation::pairwise, int workers=-1) -> Dtype {
+    auto sum_ = sum(a, method, workers);
     return sum_ /= a.size();
   }
 
+  template <class Dtype>
+  auto mean(const ndarray<Dtype>& a, const axes_type& axes, bool keepdims=false,
+	    summation method=summation::pairwise) -> ndarray<Dtype> {
+    // the sums over `axes` divided in place by the number of elements they add
+    auto ret = sum(a, axes, keepdims, method);
+    intp count = 1;
+    for (auto ax : _normalize_axes(axes, a.ndim()))
+      count *= a.shape(ax);
+    for (auto out=ret.data(), end=out + ret.size(); out!=end; ++out)
+      *out /= count;
+    return ret;
+  }
+
+  template <class Dtype>
+  auto mean(const ndarray<Dtype>& a, axis_type axis, bool keepdims=false,
+	    summation method=summation::pairwise) -> ndarray<Dtype> {
+    return mean(a, axes_type{axis}, keepdims, method);
+  }
+
+  template <class Dtype>
+  using _float_type = std::conditional_t<std::is_floating_point_v<Dtype>, Dtype, float64>;
+
+  namespace _reduction {
+
+    template <class T>
+    struct _moments {
+      // count, mean and sum of the squared deviations from the mean of a set of numbers,
+      // merged with those of another set as in Chan, Golub and LeVeque
+      T n = 0, mean = 0, m2 = 0;
+
+      void merge(const _moments& other) {
+	if (other.n == 0)
+	  return;
+	auto total = n + other.n;
+	auto delta = other.mean - mean;
+	mean += delta * (other.n / total);
+	m2 += other.m2 + delta * delta * (n * other.n / total);
+	n = total;
+      }
+    };
+
+    constexpr intp moments_block = 1024;
+
+    template <class T, class Dtype>
+    _moments<T> _moments_run(const Dtype* p, intp n, intp stride) {
+      // blocks of moments_block elements are read twice while in cache, for their mean and then
+      // their squared deviations, and merged
+      _moments<T> ret;
+      for (intp i0=0; i0<n; i0+=moments_block) {
+	auto q = p + i0*stride;
+	_moments<T> block;
+	auto m = std::min(moments_block, n - i0);
+	block.n = m;
+	block.mean = pairwise_sum<T>(q, m, stride) / m;
+	block.m2 = pairwise_sum<T>(q, m, stride, [mu=block.mean](Dtype x) {
+	  auto d = T(x) - mu;
+	  return d * d;
+	});
+	ret.merge(block);
+      }
+      return ret;
+    }
+
+    template <class T, class Dtype>
+    _moments<T> _moments_all(const ndarray<Dtype>& a, int workers) {
+      // by chunks merged in order (see _map_chunks)
+      auto partial = _map_chunks<_moments<T>>(a, workers, [](const Dtype* p, intp n, intp stride) {
+	return _moments_run<T>(p, n, stride);
+      });
+      _moments<T> ret;
+      for (const auto& m : partial)
+	ret.merge(m);
+      return ret;
+    }
+
+    template <class T, class Dtype>
+    ndarray<T> _var_axes(const ndarray<Dtype>& a, const axes_type& axes, int ddof, bool keepdims) {
+      // The variances over `axes` in a single pass over the memory, in its order as _sum_axes:
+      // along each fiber by blocks when the reduced axes are the innermost ones, or else by
+      // Welford's update of tiles of consecutive outputs with each row.
+      auto reduced = _normalize_axes(axes, a.ndim());
+      std::sort(reduced.begin(), reduced.end());
+      if (std::adjacent_find(reduced.begin(), reduced.end()) != reduced.end())
+	throw std::invalid_argument("ValueError: duplicate value in 'axis'");
+      shape_type shape;
+      for (axis_type ax=0; ax<a.ndim(); ax++)
+	if (not std::binary_search(reduced.begin(), reduced.end(), ax))
+	  shape.push_back(a.shape(ax));
+	else if (keepdims)
+	  shape.push_back(1);
+      auto out = empty<T>(shape);
+      if (out.size() == 0)
+	return out;
+      _runs rows(a.shape(), a.strides(), reduced), cols(a.shape(), a.strides(), _complement_axes(reduced, a.ndim()));
+      auto count = T(rows.size());
+      auto divisor = std::max(count - ddof, T(0));
+      auto out_ = out.data();
+      if (std::abs(rows.stride) <= std::abs(cols.stride) or cols.n == 1 or rows.size() == 0) {
+	for (auto col : cols.offsets)
+	  for (intp j=0; j<cols.n; j++) {
+	    _moments<T> acc;
+	    for (auto row : rows.offsets)
+	      acc.merge(_moments_run<T>(a.data() + col + j*cols.stride + row, rows.n, rows.stride));
+	    *out_++ = rows.size() == 0 ? T(NAN) : acc.m2 / divisor;
+	  }
+	return out;
+      }
+      std::vector<T> mean(axis_tile);
+      for (auto col : cols.offsets)
+	for (intp j0=0; j0<cols.n; j0+=axis_tile) {
+	  auto m = std::min(axis_tile, cols.n - j0);
+	  auto p = a.data() + col + j0*cols.stride;
+	  std::fill(mean.begin(), mean.begin() + m, T(0));
+	  std::fill(out_, out_ + m, T(0));
+	  for (intp i=0; i<rows.size(); i++) {
+	    auto row = p + rows.offset(i);
+	    auto inv = T(1) / (i + 1);
+	    for (intp j=0; j<m; j++) {
+	      T x = row[j*cols.stride];
+	      auto d = x - mean[j];
+	      mean[j] += d * inv;
+	      out_[j] += d * (x - mean[j]);
+	    }
+	  }
+	  for (intp j=0; j<m; j++)
+	    out_[j] /= divisor;
+	  out_ += m;
+	}
+      return out;
+    }
+
+  }
+
+  // Variances and standard deviations are computed in one pass over the data, by blocks whose
+  // moments are merged, which is as accurate as subtracting the mean first.
+
+  template <class Dtype>
+  auto var(const ndarray<Dtype>& a, python::NoneType axis=python::None, int ddof=0, int workers=-1)
+    -> _float_type<Dtype> {
+    // The variance of all the elements, sum((a - a.mean())^2) / (a.size - ddof). Large arrays
+    // are reduced by `workers` threads (-1 for all the CPUs) with the same result for any number of them.
+    using T = _float_type<Dtype>;
+    auto m = _reduction::_moments_all<T>(a, workers);
+    return a.size() == 0 ? T(NAN) : m.m2 / std::max(m.n - ddof, T(0));
+  }
+
+  template <class Dtype>
+  auto var(const ndarray<Dtype>& a, const axes_type& axes, int ddof=0, bool keepdims=false)
+    -> ndarray<_float_type<Dtype>> {
+    return _reduction::_var_axes<_float_type<Dtype>>(a, axes, ddof, keepdims);
+  }
+
+  template <class Dtype>
+  auto var(const ndarray<Dtype>& a, axis_type axis, int ddof=0, bool keepdims=false)
+    -> ndarray<_float_type<Dtype>> {
+    return _reduction::_var_axes<_float_type<Dtype>>(a, {axis}, ddof, keepdims);
+  }
+
+  template <class Dtype>
+  auto std(const ndarray<Dtype>& a, python::NoneType axis=python::None, int ddof=0, int workers=-1)
+    -> _float_type<Dtype> {
+    return std::sqrt(var(a, axis, ddof, workers));
+  }
+
+  template <class Dtype>
+  auto std(const ndarray<Dtype>& a, const axes_type& axes, int ddof=0, bool keepdims=false)
+    -> ndarray<_float_type<Dtype>> {
+    auto ret = var(a, axes, ddof, keepdims);
+    for (auto out=ret.data(), end=out + ret.size(); out!=end; ++out)
+      *out = std::sqrt(*out);
+    return ret;
+  }
+
+  template <class Dtype>
+  auto std(const ndarray<Dtype>& a, axis_type axis, int ddof=0, bool keepdims=false)
+    -> ndarray<_float_type<Dtype>> {
+    return std(a, axes_type{axis}, ddof, keepdims);
+  }
+
+  template <class Dtype, class Wtype>
+  auto average(const ndarray<Dtype>& a, const ndarray<Wtype>& weights) -> _float_type<decltype(Dtype() * Wtype())> {
+    // sum(a * weights) / sum(weights) for weights of the shape of `a`
+    using T = _float_type<decltype(Dtype() * Wtype())>;
+    if (a.shape() != weights.shape())
+      throw std::invalid_argument("TypeError: Axis must be specified when shapes of a and weights differ.");
+    auto total = sum(weights);
+    if (total == Wtype(0))
+      throw std::domain_error("ZeroDivisionError: Weights sum to zero, can't be normalized");
+    return T(sum(a * weights)) / total;
+  }
+
+  template <class Dtype, class Wtype>
+  auto average(const ndarray<Dtype>& a, axis_type axis, const ndarray<Wtype>& weights)
+    -> ndarray<_float_type<decltype(Dtype() * Wtype())>> {
+    // Weights of the shape of `a`, or 1-D along `axis`, in which case the weighted sums are
+    // computed as a matrix-vector product on the memory of `a`.
+    using T = _float_type<decltype(Dtype() * Wtype())>;
+    axis = _normalize_axes({axis}, a.ndim())[0];
+    ndarray<T> ret, total;
+    if (a.shape() == weights.shape()) {
+      ret = _reduction::_sum_axes<T>(a * weights, {axis}, false, summation::pairwise);
+      total = _reduction::_sum_axes<T>(weights, {axis}, false, summation::pairwise);
+    } else if (weights.ndim() == 1 and weights.shape(0) == a.shape(axis)) {
+      auto product = tensordot(a, weights, {{axis}, {0}});
+      ret = empty<T>(product.shape());
+      std::copy(product.data(), product.data() + product.size(), ret.data());
+      total = empty<T>(ret.shape());
+      std::fill(total.data(), total.data() + total.size(), T(sum(weights)));
+    } else {
+      throw std::invalid_argument("ValueError: Length of weights not compatible with specified axis.");
+    }
+    for (intp i=0; i<ret.size(); i++) {
+      if (total.data()[i] == T(0))
+	throw std::domain_error("ZeroDivisionError: Weights sum to zero, can't be normalized");
+      ret.data()[i] /= total.data()[i];
+    }
+    return ret;
+  }
+
+  namespace _reduction {
+
+    constexpr intp cov_block = 256; // observations merged at once by cov
+
+    template <class T, class Dtype>
+    ndarray<T> _cov(const Dtype* x, intp p, intp n, intp vs, intp os, int ddof) {
+      // The covariance of p variables observed n times, x[i*vs + k*os] being the k-th observation
+      // of the i-th variable. Blocks of observations are centered into a buffer whose co-moments
+      // come from GEMM, then merged as _moments does, so that `x` is read once.
+      auto c = zeros<T>({p, p});
+      std::vector<T> mean(p, T(0)), block_mean(p), delta(p), xc(p * cov_block), cb(p * p);
+      T count = 0;
+      for (intp k0=0; k0<n; k0+=cov_block) {
+	auto m = std::min(cov_block, n - k0);
+	for (intp i=0; i<p; i++) {
+	  auto row = x + i*vs + k0*os;
+	  block_mean[i] = pairwise_sum<T>(row, m, os) / m;
+	  for (intp k=0; k<m; k++)
+	    xc[i*m + k] = T(row[k*os]) - block_mean[i];
+	}
+	_blas::gemm(p, p, m, T(1), xc.data(), m, intp(1), xc.data(), intp(1), m, T(0), cb.data(), p, intp(1));
+	auto total = count + m;
+	auto weight = count * m / total;
+	for (intp i=0; i<p; i++)
+	  delta[i] = block_mean[i] - mean[i];
+	for (intp i=0; i<p; i++)
+	  for (intp j=0; j<p; j++)
+	    c.data()[i*p + j] += cb[i*p + j] + weight * delta[i] * delta[j];
+	for (intp i=0; i<p; i++)
+	  mean[i] += delta[i] * (m / total);
+	count = total;
+      }
+      auto divisor = std::max(count - ddof, T(0));
+      for (intp i=0; i<p*p; i++)
+	c.data()[i] /= divisor;
+      return c;
+    }
+
+  }
+
+  template <class Dtype>
+  auto cov(const ndarray<Dtype>& m, bool rowvar=true, bool bias=false) -> ndarray<_float_type<Dtype>> {
+    // The covariance matrix of the variables in the rows of `m` (its columns if not `rowvar`),
+    // normalized by N - 1, or N if `bias`. A 1-D array is a single variable, and gives a 0-d array.
+    if (m.ndim() > 2)
+      throw std::invalid_argument("ValueError: m has more than 2 dimensions");
+    using T = _float_type<Dtype>;
+    intp p = 1, n = m.size(), vs = 0, os = m.ndim() == 1 ? m.strides()[0] : 1;
+    if (m.ndim() == 2) {
+      auto v = rowvar ? 0 : 1;
+      p = m.shape(v);
+      n = m.shape(1 - v);
+      vs = m.strides()[v];
+      os = m.strides()[1 - v];
+    }
+    auto c = _reduction::_cov<T>(m.data(), p, n, vs, os, bias ? 0 : 1);
+    if (m.ndim() == 2)
+      return c;
+    auto ret = empty<T>(shape_type{});
+    ret.data()[0] = c.data()[0];
+    return ret;
+  }
+
+  template <class Dtype>
+  auto corrcoef(const ndarray<Dtype>& x, bool rowvar=true) -> ndarray<_float_type<Dtype>> {
+    // the Pearson correlation coefficients, cov(x)[i, j] / sqrt(cov(x)[i, i] cov(x)[j, j]) in [-1, 1]
+    using T = _float_type<Dtype>;
+    auto c = cov(x, rowvar);
+    if (c.ndim() == 0) {
+      c.data()[0] /= c.data()[0];
+      return c;
+    }
+    auto p = c.shape(0);
+    std::vector<T> d(p);
+    for (intp i=0; i<p; i++)
+      d[i] = std::sqrt(c.data()[i*p + i]);
+    for (intp i=0; i<p; i++)
+      for (intp j=0; j<p; j++)
+	c.data()[i*p + j] = std::clamp(c.data()[i*p + j] / d[i] / d[j], T(-1), T(1));
+    return c;
+  }
+
+  template <class Dtype1, class Dtype2>
+  auto tensordot(const ndarray<Dtype1>& a, const ndarray<Dtype2>& b,
+		 const std::pair<axes_type, axes_type>& axes)
+    -> ndarray<decltype(Dtype1() * Dtype2())> {
+    /**
+     * Sum products over `axes.first` of `a` and `axes.second` of `b`.
+     * The free axes of `a` and `b` are merged into the rows and the columns of a matrix product,
+     * which is computed by _blas::gemm directly on the original memory when the strides allow it.
+     * Otherwise the operand is copied once into the required layout.
+     */
+    using OutputType = decltype(Dtype1() * Dtype2());
+    
+    auto a_axes = _normalize_axes(axes.first, a.ndim());
+    auto b_axes = _normalize_axes(axes.second, b.ndim());
+    if (a_axes.size() != b_axes.size())
+      throw std::invalid_argument("ValueError: tensordot: the numbers of axes to sum over differ");
+    for (std::size_t i=0; i<a_axes.size(); i++)
+      if (a.shape(a_axes[i]) != b.shape(b_axes[i]))
+	throw std::invalid_argument("ValueError: shape-mismatch for sum");
+
+    auto a_free = _complement_axes(a_axes, a.ndim());
+    auto b_free = _complement_axes(b_axes, b.ndim());
+    if (a_free.size() + a_axes.size() != std::size_t(a.ndim())
+	or b_free.size() + b_axes.size() != std::size_t(b.ndim()))
+      throw std::invalid_argument("ValueError: tensordot: repeated axis");
+
+    shape_type outshape;
+    intp m = 1, n = 1, k = 1;
+    for (auto ax : a_free) {
+      outshape.push_back(a.shape(ax));
+      m *= a.shape(ax);
+    }
+    for (auto ax : b_free) {
+      outshape.push_back(b.shape(ax));
+      n *= b.shape(ax);
+    }
+    for (auto ax : a_axes)
+      k *= a.shape(ax);
+
+    // a as an (m, k) matrix
+    auto a_ = a;
+    intp rsa, csa;
+    if (not (_merge_axes(a.shape(), a.strides(), a_free, rsa)
+	     and _merge_axes(a.shape(), a.strides(), a_axes, csa))) {
+      a_free.insert(a_free.end(), a_axes.begin(), a_axes.end());
+      a_ = a.transpose(a_free).copy();
+      rsa = k;
+      csa = 1;
+    }
+
+    // b as a (k, n) matrix
+    auto b_ = b;
+    intp rsb, csb;
+    if (not (_merge_axes(b.shape(), b.strides(), b_axes, rsb)
+	     and _merge_axes(b.shape(), b.strides(), b_free, csb))) {
+      b_axes.insert(b_axes.end(), b_free.begin(), b_free.end());
+      b_ = b.transpose(b_axes).copy();
+      rsb = n;
+      csb = 1;
+    }
+
+    auto out = empty<OutputType>(outshape);
+    _blas::gemm(m, n, k, OutputType(1), a_.data(), rsa, csa, b_.data(), rsb, csb,
+		OutputType(0), out.data(), n, 1);
+    return out;
+  }
+
+  template <class Dtype1, class Dtype2>
+  auto tensordot(const ndarray<Dtype1>& a, const ndarray<Dtype2>& b, int axes=2)
+    -> ndarray<decltype(Dtype1() * Dtype2())> {
+    // sum over the last `axes` axes of `a` and the first `axes` axes of `b`
+    if (axes < 0 or axes > a.ndim() or axes > b.ndim())
+      throw std::invalid_argument("ValueError: tensordot: invalid number of axes " + python::str(axes));
+    axes_type a_axes(axes), b_axes(axes);
+    std::iota(a_axes.begin(), a_axes.end(), a.ndim() - axes);
+    std::iota(b_axes.begin(), b_axes.end(), 0);
+    return tensordot(a, b, {a_axes, b_axes});
+  }
+
   template <class Dtype1, class Dtype2>
   auto dot(const ndarray<Dtype1>& a, const ndarray<Dtype2>& b) 
+    -> ndarray<decltype(Dtype1() * Dtype2())>
+  {
+    // https://numpy.org/doc/stable/reference/generated/numpy.dot.html
+    // - 1-D & 1-D: inner product (returned as a 0-d array; use vdot() to get a scolar)
+    // - 2-D & 2-D: matrix multiplication
+    // - 0-D & any: multiplication
+    // - N-D & 1-D: sum product over the last axis of `a` and `b`
+    // - N-D & M-D (M>=2): sum product over the last axis of `a` and the second-to-last of `b`
+    if (a.ndim() == 0 or b.ndim() == 0)
+      return multiply(a, b);
+
+    axis_type a_axis = a.ndim() - 1;
+    axis_type b_axis = (b.ndim() == 1) ? 0 : b.ndim() - 2;
+    if (a.shape(a_axis) != b.shape(b_axis))
+      throw std::invalid_argument("ValueError: shapes "
+				  + python::str(a.shape()) + " and " + python::str(b.shape())
+				  + " not aligned: "
+				  + python::str(a.shape(a_axis)) + " (dim " + python::str(a_axis) + ") != "
+				  + python::str(b.shape(b_axis)) + " (dim " + python::str(b_axis) + ")");
+    return tensordot(a, b, {{a_axis}, {b_axis}});
+  }
+
+  template <class Dtype1, class Dtype2>
+  auto vdot(const ndarray<Dtype1>& a, const ndarray<Dtype2>& b) 
     -> decltype(Dtype1() * Dtype2())
   {
-    if (a.ndim() == b.ndim() == 1) {
-      if (a.size() != b.size())
-	throw std::invalid_argument("ValueError: shapes "
-				    + python::str(a.shape()) + " and " + python::str(b.shape())
-				    + " not aligned: "
-				    + python::str(a.shape(0)) + " (dim 0) != "
-				    + python::str(b.shape(0)) + " (dim 0)");
-      
-      // Broadcasting, constructing & destructing temporary objects are so heavy
-      // that (1) is much slower than (2)
-      
-      // (1)
-      // return sum(a * b);
-      
-      // (2)
-      using OutputType = decltype(Dtype1() * Dtype2());
-      return std::inner_product(a.begin(), a.end(), b.begin(), OutputType(0));
+    // Flattens the inputs and returns their inner product as a scolar.
+    // The complex conjugate of `a` is taken, as in the original NumPy.
+    if (a.size() != b.size())
+      throw std::invalid_argument("ValueError: vdot: input arrays must have the same size, but "
+				  + python::str(a.size()) + " != " + python::str(b.size()));
+    using OutputType = decltype(Dtype1() * Dtype2());
+
+    axes_type all_axes_a(a.ndim()), all_axes_b(b.ndim());
+    std::iota(all_axes_a.begin(), all_axes_a.end(), 0);
+    std::iota(all_axes_b.begin(), all_axes_b.end(), 0);
+
+    auto a_ = a;
+    auto b_ = b;
+    intp inc_a, inc_b;
+    if (not _merge_axes(a.shape(), a.strides(), all_axes_a, inc_a)) {
+      a_ = a.copy();
+      inc_a = 1;
+    }
+    if (not _merge_axes(b.shape(), b.strides(), all_axes_b, inc_b)) {
+      b_ = b.copy();
+      inc_b = 1;
     }
-    throw std::logic_error("NotImplementedError: dot product of 2+d arrays");
+    return _blas::dot<OutputType, true>(a.size(), a_.data(), inc_a, b_.data(), inc_b);
   }
   
   template <class Dtype1, class Dtype2>
@@ -73,22 +865,12 @@ namespace numpy {
     
     using OutputType = decltype(Dtype1() * Dtype2());
     shape_type shape;
-    if (a_d == 2 and b_d == 2) {
-      shape.resize(2);
-      shape[0] = a.shape(0);
-      shape[1] = b.shape(1);
-    }
-    if (a_d == 1) {
-      shape.resize(1);
-      shape[0] = b.shape(1);
-    }
-    if (b_d == 1) {
-      shape.resize(1);
-      shape[0] = a.shape(0);
-    }
+    if (a_d == 2)
+      shape.push_back(a.shape(0));
+    if (b_d == 2)
+      shape.push_back(b.shape(1));
 
-    auto out = empty<OutputType>({a_d == 1 ? 1 : a.shape(0),
-				  b_d == 1 ? 1 : b.shape(1)});
+    auto out = empty<OutputType>(shape);
     return matmul(a, b, out);
   }
   
@@ -97,38 +879,42 @@ namespace numpy {
     if (a.ndim() * b.ndim() == 0) {
       throw std::invalid_argument("ValueError: matmul: Scolar is not allowed.");
     }
-			     
-    if (a.ndim() == 1) {
-      auto n = a.size();
-      matmul(a.reshape(1, n), b, out);
-      out = out.reshape(-1);
-      return out;
-    }
 
-    if (b.ndim() == 1) {
-      auto n = b.size();
-      matmul(a, b.reshape(n, 1), out);
-      out = out.reshape(-1);
-      return out;
-    }    
-    
-    if (a.ndim() == 2 and b.ndim() == 2) {      
-      if (a.shape(1) != b.shape(0))
-	throw std::invalid_argument("ValueError: matmul: Input operand 1 has a mismatch in its core dimension 0, with gufunc signature (n?,k),(k,m?)->(n?,m?) (size " + python::str(a.shape(1)) + " is different from " + python::str(b.shape(0)) + ")");
-
-      auto b_T = b.T();      
-      auto n = b_T.shape(0);
-      int idx = -1;
-      std::generate(out.begin(), out.end(),
-      		    [&](){idx++; return dot(a(idx / n), b_T(idx % n));});
-      return out;
+    if (a.ndim() <= 2 and b.ndim() <= 2) {
+      // 1-D operands are treated as a row vector (`a`) and a column vector (`b`),
+      // which is expressed by a zero stride along the missing axis.
+      bool a_is_vec = (a.ndim() == 1);
+      bool b_is_vec = (b.ndim() == 1);
+      intp m = a_is_vec ? 1 : a.shape(0);
+      intp k = a.shape(a.ndim() - 1);
+      intp n = b_is_vec ? 1 : b.shape(1);
       
-      // auto m = a.shape(0);
-      // auto n = b.shape(1);
-      // for(int i=0; i<m; i++)
-      // 	for(int j=0; j<n; j++)
-      // 	  out[{i, j}] = dot(a(i), b_T(j));
-      // return out;
+      if (k != b.shape(0))
+	throw std::invalid_argument("ValueError: matmul: Input operand 1 has a mismatch in its core dimension 0, with gufunc signature (n?,k),(k,m?)->(n?,m?) (size " + python::str(k) + " is different from " + python::str(b.shape(0)) + ")");
+      if (out.size() != m * n or out.ndim() != dim_type(not a_is_vec) + dim_type(not b_is_vec))
+	throw std::invalid_argument("ValueError: matmul: output operand has a shape " + python::str(out.shape())
+				    + " which does not match the expected one");
+
+      // avoid the memory overlap problem (issue #13)
+      if (may_share_memory(a, out)) {
+	auto tmp = a.copy();
+	return matmul(tmp, b, out);
+      }
+      if (may_share_memory(b, out)) {
+	auto tmp = b.copy();
+	return matmul(a, tmp, out);
+      }
+
+      intp rsa = a_is_vec ? 0 : a.strides()[0];
+      intp csa = a.strides()[a.ndim() - 1];
+      intp rsb = b.strides()[0];
+      intp csb = b_is_vec ? 0 : b.strides()[1];
+      intp rsc = a_is_vec ? 0 : out.strides()[0];
+      intp csc = b_is_vec ? 0 : out.strides()[out.ndim() - 1];
+      
+      _blas::gemm(m, n, k, OutputType(1), a.data(), rsa, csa, b.data(), rsb, csb,
+		  OutputType(0), out.data(), rsc, csc);
+      return out;
     }
     
     // matmul of stack of matrices has not been implemented yet
@@ -0,0 +1,257 @@
+// Low-level kernels in the spirit of the BLAS, working on raw strided memory.
+// Strides are measured in elements (not in bytes as in the original NumPy).
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <vector>
+#include <numpy/dtype.hpp>
+
+namespace numpy {
+
+  namespace _blas {
+
+    /* register tile of the GEMM micro kernel & cache blocking parameters */
+    constexpr intp MR = 4;
+    constexpr intp NR = 8;
+    constexpr intp MC = 128;
+    constexpr intp KC = 256;
+    constexpr intp NC = 2048;
+    /* triangular blocks solved without GEMM */
+    constexpr intp TRSM_NB = 32;
+
+    template <class Type>
+    inline Type _conj(const Type& x) {
+      if constexpr (is_complex<Type>::value)
+	return std::conj(x);
+      else
+	return x;
+    }
+
+    // sum(x[i] * y[i]) (conjugating x if `conj_x`) with 4 independent accumulators
+    template <class T, bool conj_x=false, class Type1, class Type2>
+    T dot(intp n, const Type1* x, intp incx, const Type2* y, intp incy) {
+      T acc[4] = {T(0), T(0), T(0), T(0)};
+      intp i = 0;
+      auto get_x = [x, incx](intp i) {
+	if constexpr (conj_x) return T(_conj(x[i * incx]));
+	else return T(x[i * incx]);
+      };
+      if (incx == 1 and incy == 1) {
+	for (; i+4<=n; i+=4)
+	  for (intp l=0; l<4; l++)
+	    acc[l] += get_x(i+l) * T(y[i+l]);
+      }
+      for (; i<n; i++)
+	acc[0] += get_x(i) * T(y[i * incy]);
+      return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+
+    // Euclidean norm, scaled by the largest element against overflow and underflow
+    template <class T>
+    T nrm2(intp n, const T* x, intp incx) {
+      T scale = 0;
+      for (intp i=0; i<n; i++)
+	scale = std::max(scale, std::abs(x[i * incx]));
+      if (scale == T(0) or not std::isfinite(scale))
+	return scale;
+      T ssq = 0;
+      for (intp i=0; i<n; i++) {
+	auto y = x[i * incx] / scale;
+	ssq += y * y;
+      }
+      return scale * std::sqrt(ssq);
+    }
+
+    // index of the element with the largest absolute value
+    template <class T>
+    intp iamax(intp n, const T* x, intp incx) {
+      intp idx = 0;
+      decltype(std::abs(T())) maxval = -1;
+      for (intp i=0; i<n; i++) {
+	auto val = std::abs(x[i * incx]);
+	if (val > maxval) {
+	  maxval = val;
+	  idx = i;
+	}
+      }
+      return idx;
+    }
+
+    template <class T>
+    void swap(intp n, T* x, intp incx, T* y, intp incy) {
+      for (intp i=0; i<n; i++)
+	std::swap(x[i * incx], y[i * incy]);
+    }
+
+    // x <- alpha * x
+    template <class T>
+    void scal(intp n, T alpha, T* x, intp incx) {
+      for (intp i=0; i<n; i++)
+	x[i * incx] *= alpha;
+    }
+
+    // y <- alpha * x + y
+    template <class T>
+    void axpy(intp n, T alpha, const T* x, intp incx, T* y, intp incy) {
+      if (incx == 1 and incy == 1) {
+	for (intp i=0; i<n; i++)
+	  y[i] += alpha * x[i];
+	return;
+      }
+      for (intp i=0; i<n; i++)
+	y[i * incy] += alpha * x[i * incx];
+    }
+
+    // y <- alpha * A x + beta * y  for an m x n matrix A
+    template <class T, class Type1, class Type2>
+    void gemv(intp m, intp n, T alpha,
+	      const Type1* a, intp rsa, intp csa,
+	      const Type2* x, intp incx,
+	      T beta, T* y, intp incy) {
+      for (intp i=0; i<m; i++) {
+	auto sum = (n > 0) ? alpha * dot<T>(n, a + i*rsa, csa, x, incx) : T(0);
+	y[i * incy] = (beta == T(0)) ? sum : sum + beta * y[i * incy];
+      }
+    }
+
+    // Copies an mc x kc block of A into row panels of height MR, padded with zeros.
+    template <class T, class Type>
+    void _pack_a(intp mc, intp kc, const Type* a, intp rs, intp cs, T* buf) {
+      for (intp i=0; i<mc; i+=MR) {
+	auto mr = std::min(MR, mc - i);
+	for (intp p=0; p<kc; p++) {
+	  intp ii = 0;
+	  for (; ii<mr; ii++)
+	    *buf++ = T(a[(i+ii)*rs + p*cs]);
+	  for (; ii<MR; ii++)
+	    *buf++ = T(0);
+	}
+      }
+    }
+
+    // Copies a kc x nc block of B into column panels of width NR, padded with zeros.
+    template <class T, class Type>
+    void _pack_b(intp kc, intp nc, const Type* b, intp rs, intp cs, T* buf) {
+      for (intp j=0; j<nc; j+=NR) {
+	auto nr = std::min(NR, nc - j);
+	for (intp p=0; p<kc; p++) {
+	  intp jj = 0;
+	  for (; jj<nr; jj++)
+	    *buf++ = T(b[p*rs + (j+jj)*cs]);
+	  for (; jj<NR; jj++)
+	    *buf++ = T(0);
+	}
+      }
+    }
+
+    // C[:mr, :nr] += alpha * (packed A panel) (packed B panel)
+    template <class T>
+    inline void _micro_kernel(intp kc, const T* a, const T* b,
+			      T* c, intp rsc, intp csc, intp mr, intp nr, T alpha) {
+      T acc[MR][NR];
+      for (intp i=0; i<MR; i++)
+	for (intp j=0; j<NR; j++)
+	  acc[i][j] = T(0);
+
+      for (intp p=0; p<kc; p++, a+=MR, b+=NR)
+	for (intp i=0; i<MR; i++)
+	  for (intp j=0; j<NR; j++)
+	    acc[i][j] += a[i] * b[j];
+
+      for (intp i=0; i<mr; i++)
+	for (intp j=0; j<nr; j++)
+	  c[i*rsc + j*csc] += alpha * acc[i][j];
+    }
+
+    // C <- alpha * A B + beta * C  for A: m x k, B: k x n, C: m x n
+    template <class T, class Type1, class Type2>
+    void gemm(intp m, intp n, intp k, T alpha,
+	      const Type1* a, intp rsa, intp csa,
+	      const Type2* b, intp rsb, intp csb,
+	      T beta, T* c, intp rsc, intp csc) {
+      if (m == 0 or n == 0)
+	return;
+
+      // matrix-vector products do not pay for packing
+      if (n == 1)
+	return gemv(m, k, alpha, a, rsa, csa, b, rsb, beta, c, rsc);
+      if (m == 1)
+	return gemv(n, k, alpha, b, csb, rsb, a, csa, beta, c, csc);
+
+      for (intp i=0; i<m; i++)
+	for (intp j=0; j<n; j++) {
+	  auto& c_ij = c[i*rsc + j*csc];
+	  c_ij = (beta == T(0)) ? T(0) : beta * c_ij;
+	}
+      if (k == 0 or alpha == T(0))
+	return;
+
+      auto kc_max = std::min(KC, k);
+      std::vector<T> buf_a(((std::min(MC, m) + MR - 1) / MR) * MR * kc_max);
+      std::vector<T> buf_b(((std::min(NC, n) + NR - 1) / NR) * NR * kc_max);
+
+      for (intp jc=0; jc<n; jc+=NC) {
+	auto nc = std::min(NC, n - jc);
+	for (intp pc=0; pc<k; pc+=KC) {
+	  auto kc = std::min(KC, k - pc);
+	  _pack_b(kc, nc, b + pc*rsb + jc*csb, rsb, csb, buf_b.data());
+	  for (intp ic=0; ic<m; ic+=MC) {
+	    auto mc = std::min(MC, m - ic);
+	    _pack_a(mc, kc, a + ic*rsa + pc*csa, rsa, csa, buf_a.data());
+	    for (intp jr=0; jr<nc; jr+=NR)
+	      for (intp ir=0; ir<mc; ir+=MR)
+		_micro_kernel(kc, buf_a.data() + ir*kc, buf_b.data() + jr*kc,
+			      c + (ic+ir)*rsc + (jc+jr)*csc, rsc, csc,
+			      std::min(MR, mc - ir), std::min(NR, nc - jr), alpha);
+	  }
+	}
+      }
+    }
+
+    // B <- inv(A) B  for a triangular m x m matrix A and an m x n matrix B, row by row
+    template <class T>
+    void _trsm_unblocked(bool lower, bool unit_diag, intp m, intp n,
+			 const T* a, intp rsa, intp csa, T* b, intp rsb, intp csb) {
+      for (intp l=0; l<m; l++) {
+	intp i = lower ? l : m - 1 - l;
+	auto b_i = b + i*rsb;
+	// the rows solved before, 0, ..., i-1 if lower and i+1, ..., m-1 otherwise
+	intp k0 = lower ? 0 : i + 1;
+	for (intp k=k0; k<k0+l; k++)
+	  axpy(n, -a[i*rsa + k*csa], b + k*rsb, csb, b_i, csb);
+	if (not unit_diag)
+	  scal(n, T(1) / a[i*rsa + i*csa], b_i, csb);
+      }
+    }
+
+    // B <- inv(A) B  for a triangular m x m matrix A and an m x n matrix B, solved in place.
+    // A is split recursively so that most of the work is done by GEMM on the off-diagonal block.
+    template <class T>
+    void trsm(bool lower, bool unit_diag, intp m, intp n,
+	      const T* a, intp rsa, intp csa, T* b, intp rsb, intp csb) {
+      if (m <= TRSM_NB or n == 0)
+	return _trsm_unblocked(lower, unit_diag, m, n, a, rsa, csa, b, rsb, csb);
+
+      auto m1 = m / 2;
+      auto a22 = a + m1*rsa + m1*csa;
+      auto b2 = b + m1*rsb;
+      if (lower) {
+	trsm(lower, unit_diag, m1, n, a, rsa, csa, b, rsb, csb);
+	// B2 <- B2 - A21 B1
+	gemm(m - m1, n, m1, T(-1), a + m1*rsa, rsa, csa, b, rsb, csb, T(1), b2, rsb, csb);
+	trsm(lower, unit_diag, m - m1, n, a22, rsa, csa, b2, rsb, csb);
+      } else {
+	trsm(lower, unit_diag, m - m1, n, a22, rsa, csa, b2, rsb, csb);
+	// B1 <- B1 - A12 B2
+	gemm(m1, n, m - m1, T(-1), a + m1*csa, rsa, csa, b2, rsb, csb, T(1), b, rsb, csb);
+	trsm(lower, unit_diag, m1, n, a, rsa, csa, b, rsb, csb);
+      }
+    }
+
+  }
+
+}
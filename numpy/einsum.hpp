@@ -0,0 +1,473 @@
+// https://numpy.org/doc/stable/reference/generated/numpy.einsum.html
+// https://numpy.org/doc/stable/reference/generated/numpy.einsum_path.html
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cctype>
+#include <type_traits>
+
+namespace numpy {
+
+  template <class Dtype> ndarray<Dtype> ones(const shape_type& shape);
+
+  using einsum_path_type = std::vector<std::pair<int, int>>;
+
+  namespace _einsum {
+
+    struct subscripts_type {
+      std::vector<std::string> inputs;
+      std::string output;
+    };
+
+    inline subscripts_type _parse_impl(const std::string& subscripts) {
+      std::string s;
+      for (auto c : subscripts)
+	if (c != ' ')
+	  s += c;
+      if (s.find("...") != std::string::npos)
+	throw std::logic_error("NotImplementedError: einsum: ellipsis is not supported");
+
+      subscripts_type ret;
+      auto arrow = s.find("->");
+      auto lhs = s.substr(0, arrow);
+      std::string::size_type first = 0, last;
+      do {
+	last = lhs.find(',', first);
+	ret.inputs.push_back(lhs.substr(first, last - first));
+	first = last + 1;
+      } while (last != std::string::npos);
+
+      std::map<char, int> count;
+      for (const auto& input : ret.inputs)
+	for (auto c : input) {
+	  if (not std::isalpha(static_cast<unsigned char>(c)))
+	    throw std::invalid_argument(std::string("ValueError: invalid subscript '") + c
+					+ "' in einstein sum subscripts string, subscripts must be letters");
+	  count[c]++;
+	}
+
+      if (arrow == std::string::npos) {
+	// implicit mode: the output consists of the labels appearing only once, in alphabetical order
+	for (const auto& [c, n] : count)
+	  if (n == 1)
+	    ret.output += c;
+      } else {
+	ret.output = s.substr(arrow + 2);
+	for (auto c : ret.output) {
+	  if (not count.count(c))
+	    throw std::invalid_argument(std::string("ValueError: einstein sum subscripts string included output subscript '")
+					+ c + "' which never appeared in an input");
+	  if (std::count(ret.output.begin(), ret.output.end(), c) > 1)
+	    throw std::invalid_argument(std::string("ValueError: einstein sum subscripts string includes output subscript '")
+					+ c + "' multiple times");
+	}
+      }
+      return ret;
+    }
+
+    inline subscripts_type parse(const std::string& subscripts) {
+      // Parsed subscripts are cached since the same expression is typically evaluated many times.
+      static std::map<std::string, subscripts_type> cache;
+      static std::mutex mtx;
+      std::lock_guard<std::mutex> lock(mtx);
+      auto itr = cache.find(subscripts);
+      if (itr != cache.end())
+	return itr->second;
+      auto ret = _parse_impl(subscripts);
+      if (cache.size() >= 1024)
+	cache.clear();
+      cache.emplace(subscripts, ret);
+      return ret;
+    }
+
+    inline bool _contains(const std::string& labels, char c) {
+      return labels.find(c) != std::string::npos;
+    }
+
+    inline std::string _unique(const std::string& labels) {
+      std::string ret;
+      for (auto c : labels)
+	if (not _contains(ret, c))
+	  ret += c;
+      return ret;
+    }
+
+    // labels of the result of contracting `a` & `b`: those still needed by `others`
+    inline std::string _result_labels(const std::string& a, const std::string& b,
+				      const std::vector<std::string>& others) {
+      std::string ret;
+      for (auto c : _unique(a + b))
+	for (const auto& other : others)
+	  if (_contains(other, c)) {
+	    ret += c;
+	    break;
+	  }
+      return ret;
+    }
+
+    inline double _flops(const std::string& labels, const std::map<char, intp>& sizes) {
+      double ret = 1;
+      for (auto c : _unique(labels))
+	ret *= sizes.at(c);
+      return ret;
+    }
+
+    inline einsum_path_type _greedy_path(std::vector<std::string> operands, const std::string& output,
+					 const std::map<char, intp>& sizes) {
+      // At each step, contracts the pair with the fewest flops, preferring pairs sharing a label.
+      einsum_path_type path;
+      while (operands.size() > 1) {
+	int n = operands.size();
+	int best_i = 0, best_j = 1;
+	std::pair<bool, double> best_cost(true, std::numeric_limits<double>::infinity());
+	for (int i=0; i<n; i++)
+	  for (int j=i+1; j<n; j++) {
+	    bool is_outer = _unique(operands[i] + operands[j]).size()
+	      == _unique(operands[i]).size() + _unique(operands[j]).size();
+	    std::pair<bool, double> cost(is_outer, _flops(operands[i] + operands[j], sizes));
+	    if (cost < best_cost) {
+	      best_cost = cost;
+	      best_i = i;
+	      best_j = j;
+	    }
+	  }
+	std::vector<std::string> others{output};
+	for (int k=0; k<n; k++)
+	  if (k != best_i and k != best_j)
+	    others.push_back(operands[k]);
+	auto result = _result_labels(operands[best_i], operands[best_j], others);
+	path.emplace_back(best_i, best_j);
+	operands.erase(operands.begin() + best_j);
+	operands.erase(operands.begin() + best_i);
+	operands.push_back(result);
+      }
+      return path;
+    }
+
+    inline einsum_path_type _optimal_path(const std::vector<std::string>& operands, const std::string& output,
+					  const std::map<char, intp>& sizes) {
+      // Dynamic programming over the subsets of operands, which finds the cheapest binary contraction tree.
+      int n = operands.size();
+      int full = (1 << n) - 1;
+      std::vector<std::string> labels(1 << n);
+      std::vector<double> cost(1 << n, std::numeric_limits<double>::infinity());
+      std::vector<int> split(1 << n, 0);
+
+      for (int set=1; set<=full; set++) {
+	// labels of the intermediate result of `set`: those also needed outside `set`
+	std::string inside, outside = output;
+	for (int k=0; k<n; k++)
+	  ((set >> k) & 1 ? inside : outside) += operands[k];
+	labels[set] = _result_labels(inside, "", {outside});
+	if ((set & (set - 1)) == 0) {
+	  int k = 0;
+	  while (not ((set >> k) & 1))
+	    k++;
+	  labels[set] = operands[k];
+	  cost[set] = 0;
+	  continue;
+	}
+	for (int sub=(set-1)&set; sub>0; sub=(sub-1)&set) {
+	  int rest = set ^ sub;
+	  if (sub < rest)
+	    continue;
+	  double c = cost[sub] + cost[rest] + _flops(labels[sub] + labels[rest], sizes);
+	  if (c < cost[set]) {
+	    cost[set] = c;
+	    split[set] = sub;
+	  }
+	}
+      }
+
+      // convert the tree into a sequence of pairs of positions, as returned by numpy.einsum_path
+      einsum_path_type path;
+      std::vector<int> current(n);
+      for (int k=0; k<n; k++)
+	current[k] = 1 << k;
+      std::function<void(int)> visit = [&](int set) {
+	if ((set & (set - 1)) == 0)
+	  return;
+	int sub = split[set], rest = set ^ sub;
+	visit(sub);
+	visit(rest);
+	int i = std::find(current.begin(), current.end(), sub) - current.begin();
+	int j = std::find(current.begin(), current.end(), rest) - current.begin();
+	if (i > j)
+	  std::swap(i, j);
+	path.emplace_back(i, j);
+	current.erase(current.begin() + j);
+	current.erase(current.begin() + i);
+	current.push_back(set);
+      };
+      visit(full);
+      return path;
+    }
+
+    constexpr int optimal_path_max_operands = 6;
+
+    inline einsum_path_type path(const std::string& subscripts, const subscripts_type& parsed,
+				 const std::vector<shape_type>& shapes, const std::map<char, intp>& sizes) {
+      // Chosen paths are cached for each combination of subscripts & operand shapes.
+      static std::map<std::pair<std::string, std::vector<shape_type>>, einsum_path_type> cache;
+      static std::mutex mtx;
+      auto key = std::make_pair(subscripts, shapes);
+      {
+	std::lock_guard<std::mutex> lock(mtx);
+	auto itr = cache.find(key);
+	if (itr != cache.end())
+	  return itr->second;
+      }
+      auto ret = (parsed.inputs.size() <= optimal_path_max_operands)
+	? _optimal_path(parsed.inputs, parsed.output, sizes)
+	: _greedy_path(parsed.inputs, parsed.output, sizes);
+      std::lock_guard<std::mutex> lock(mtx);
+      if (cache.size() >= 1024)
+	cache.clear();
+      cache.emplace(key, ret);
+      return ret;
+    }
+
+    template <class Dtype>
+    struct labeled_array {
+      ndarray<Dtype> array;
+      std::string labels;
+    };
+
+    template <class Dtype>
+    labeled_array<Dtype> _take_diagonal(const labeled_array<Dtype>& x) {
+      // "ii->i": repeated labels are merged into one axis whose stride is the sum of their strides.
+      auto labels = _unique(x.labels);
+      if (labels.size() == x.labels.size())
+	return x;
+      shape_type shape;
+      stride_type strides;
+      for (auto c : labels) {
+	intp stride = 0;
+	for (std::size_t ax=0; ax<x.labels.size(); ax++)
+	  if (x.labels[ax] == c)
+	    stride += x.array.strides()[ax];
+	shape.push_back(x.array.shape(x.labels.find(c)));
+	strides.push_back(stride);
+      }
+      return {as_strided(x.array, shape, strides), labels};
+    }
+
+    template <class Dtype>
+    labeled_array<Dtype> _sum_out(const labeled_array<Dtype>& x, const std::string& keep) {
+      // Sums over the labels not in `keep`, as a matrix-vector product with a vector of ones.
+      axes_type axes;
+      shape_type shape;
+      std::string labels;
+      for (std::size_t ax=0; ax<x.labels.size(); ax++)
+	if (_contains(keep, x.labels[ax])) {
+	  labels += x.labels[ax];
+	} else {
+	  axes.push_back(ax);
+	  shape.push_back(x.array.shape(ax));
+	}
+      if (axes.empty())
+	return x;
+      axes_type ones_axes(axes.size());
+      std::iota(ones_axes.begin(), ones_axes.end(), 0);
+      return {tensordot(x.array, ones<Dtype>(shape), {axes, ones_axes}), labels};
+    }
+
+    template <class Dtype>
+    bool _group_strides(const ndarray<Dtype>& x, const std::vector<std::size_t>& group_sizes,
+			stride_type& strides) {
+      // Checks if the consecutive groups of axes of `x` can each be traversed with a single stride.
+      axis_type ax = 0;
+      strides.clear();
+      for (auto size : group_sizes) {
+	axes_type axes(size);
+	std::iota(axes.begin(), axes.end(), ax);
+	ax += size;
+	intp stride;
+	if (not _merge_axes(x.shape(), x.strides(), axes, stride))
+	  return false;
+	strides.push_back(stride);
+      }
+      return true;
+    }
+
+    template <class Dtype>
+    labeled_array<Dtype> _contract(const labeled_array<Dtype>& a, const labeled_array<Dtype>& b,
+				   const std::string& keep) {
+      // Contracts two operands. Labels shared by both are either batch labels (kept)
+      // or summed over. Summations are lowered to a batched GEMM; when nothing is summed over,
+      // the contraction reduces to a broadcast multiplication.
+      std::string batch, summed, a_free, b_free;
+      for (auto c : a.labels) {
+	if (_contains(b.labels, c))
+	  (_contains(keep, c) ? batch : summed) += c;
+	else
+	  a_free += c;
+      }
+      for (auto c : b.labels)
+	if (not _contains(a.labels, c))
+	  b_free += c;
+
+      std::map<char, intp> sizes;
+      for (std::size_t ax=0; ax<a.labels.size(); ax++)
+	sizes[a.labels[ax]] = a.array.shape(ax);
+      for (std::size_t ax=0; ax<b.labels.size(); ax++)
+	sizes[b.labels[ax]] = b.array.shape(ax);
+      auto product = [&sizes](const std::string& labels) {
+	intp ret = 1;
+	for (auto c : labels)
+	  ret *= sizes.at(c);
+	return ret;
+      };
+      auto transposed = [](const labeled_array<Dtype>& x, const std::string& labels) {
+	axes_type axes;
+	for (auto c : labels)
+	  axes.push_back(x.labels.find(c));
+	return x.array.transpose(axes);
+      };
+
+      if (summed.empty()) {
+	// fused strided loop: views over all the labels with zero strides for missing ones
+	auto labels = batch + a_free + b_free;
+	shape_type shape;
+	stride_type a_strides, b_strides;
+	for (auto c : labels) {
+	  shape.push_back(sizes.at(c));
+	  auto ax_a = a.labels.find(c), ax_b = b.labels.find(c);
+	  a_strides.push_back(ax_a == std::string::npos ? 0 : a.array.strides()[ax_a]);
+	  b_strides.push_back(ax_b == std::string::npos ? 0 : b.array.strides()[ax_b]);
+	}
+	return {multiply(as_strided(a.array, shape, a_strides), as_strided(b.array, shape, b_strides)), labels};
+      }
+
+      intp nb = product(batch), m = product(a_free), n = product(b_free), k = product(summed);
+
+      // a as a stack of (m, k) matrices
+      auto a_ = transposed(a, batch + a_free + summed);
+      stride_type sa;
+      if (not _group_strides(a_, {batch.size(), a_free.size(), summed.size()}, sa)) {
+	a_ = a_.copy();
+	sa = {m * k, k, 1};
+      }
+
+      // b as a stack of (k, n) matrices
+      auto b_ = transposed(b, batch + summed + b_free);
+      stride_type sb;
+      if (not _group_strides(b_, {batch.size(), summed.size(), b_free.size()}, sb)) {
+	b_ = b_.copy();
+	sb = {k * n, n, 1};
+      }
+
+      shape_type outshape;
+      for (auto c : batch + a_free + b_free)
+	outshape.push_back(sizes.at(c));
+      auto out = empty<Dtype>(outshape);
+      auto ptr_a = a_.data();
+      auto ptr_b = b_.data();
+      auto ptr_out = out.data();
+      for (intp t=0; t<nb; t++)
+	_blas::gemm(m, n, k, Dtype(1), ptr_a + t*sa[0], sa[1], sa[2], ptr_b + t*sb[0], sb[1], sb[2],
+		    Dtype(0), ptr_out + t*m*n, n, 1);
+      return {out, batch + a_free + b_free};
+    }
+
+  }
+
+  template <class... Dtype>
+  einsum_path_type einsum_path(const std::string& subscripts, const ndarray<Dtype>&... operands) {
+    /**
+     * Returns the order of pairwise contractions used by einsum().
+     * Each pair holds the positions of the operands to be contracted in the current list of operands;
+     * they are removed from the list and the result is appended to its end.
+     */
+    auto parsed = _einsum::parse(subscripts);
+    std::vector<shape_type> shapes{operands.shape()...};
+    if (parsed.inputs.size() != shapes.size())
+      throw std::invalid_argument("ValueError: more operands provided to einstein sum function than specified in the subscripts string");
+
+    std::map<char, intp> sizes;
+    for (std::size_t i=0; i<shapes.size(); i++) {
+      if (parsed.inputs[i].size() != shapes[i].size())
+	throw std::invalid_argument("ValueError: einstein sum subscripts string does not contain the correct number of indices for operand " + python::str(int(i)));
+      for (std::size_t ax=0; ax<shapes[i].size(); ax++) {
+	auto c = parsed.inputs[i][ax];
+	auto itr = sizes.find(c);
+	if (itr != sizes.end() and itr->second != shapes[i][ax])
+	  throw std::invalid_argument(std::string("ValueError: einsum: size of label '") + c
+				      + "' does not match between operands: "
+				      + python::str(itr->second) + " != " + python::str(shapes[i][ax]));
+	sizes[c] = shapes[i][ax];
+      }
+    }
+    return _einsum::path(subscripts, parsed, shapes, sizes);
+  }
+
+  template <class... Dtype>
+  auto einsum(const std::string& subscripts, const ndarray<Dtype>&... operands)
+    -> ndarray<std::common_type_t<Dtype...>> {
+    /**
+     * Evaluates the Einstein summation convention on the operands, e.g.
+     *     einsum("ij,jk->ik", a, b) (matrix multiplication)
+     *     einsum("ii", a) (trace)
+     *     einsum("ijk,jl,kl->il", a, b, c)
+     * The operands are contracted pairwise in the order given by einsum_path(),
+     * which minimizes the number of flops, and each contraction is lowered to GEMM.
+     */
+    using OutputType = std::common_type_t<Dtype...>;
+    using labeled_array = _einsum::labeled_array<OutputType>;
+
+    auto path = einsum_path(subscripts, operands...);
+    auto parsed = _einsum::parse(subscripts);
+
+    std::vector<labeled_array> ops;
+    int i = 0;
+    auto push = [&](const auto& operand) {
+      using Type = typename std::remove_reference_t<decltype(operand)>::dtype;
+      if constexpr (std::is_same_v<Type, OutputType>)
+	ops.push_back({operand, parsed.inputs[i++]});
+      else
+	ops.push_back({operand.template astype<OutputType>(), parsed.inputs[i++]});
+    };
+    (push(operands), ...);
+
+    // labels needed by the operands other than `skip` or by the output
+    auto needed = [&](const std::vector<int>& skip) {
+      std::string ret = parsed.output;
+      for (int k=0; k<int(ops.size()); k++)
+	if (std::find(skip.begin(), skip.end(), k) == skip.end())
+	  ret += ops[k].labels;
+      return ret;
+    };
+
+    // traces & summations within each operand come first
+    for (int k=0; k<int(ops.size()); k++) {
+      ops[k] = _einsum::_take_diagonal(ops[k]);
+      ops[k] = _einsum::_sum_out(ops[k], needed({k}));
+    }
+
+    for (const auto& [i, j] : path) {
+      auto keep = needed({i, j});
+      auto a = _einsum::_sum_out(ops[i], keep + ops[j].labels);
+      auto b = _einsum::_sum_out(ops[j], keep + ops[i].labels);
+      auto result = _einsum::_contract(a, b, keep);
+      ops.erase(ops.begin() + j);
+      ops.erase(ops.begin() + i);
+      ops.push_back(_einsum::_sum_out(result, keep));
+    }
+
+    auto result = _einsum::_sum_out(ops[0], parsed.output);
+    axes_type axes;
+    for (auto c : parsed.output)
+      axes.push_back(result.labels.find(c));
+    return result.array.transpose(axes);
+  }
+
+}
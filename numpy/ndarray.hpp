@@ -34,6 +34,7 @@ namespace numpy {
     template <template <class> class UnaryOperation> friend struct ufunc_unary;
     template <template <class, class> class BinaryOperation> friend struct ufunc_binary;
     template <class Type1, class Type2> friend bool may_share_memory(const ndarray<Type1>& a, const ndarray<Type2>& b);
+    template <class Type> friend ndarray<Type> as_strided(const ndarray<Type>& x, const shape_type& shape, const stride_type& strides);
     friend struct debug;
 
   private:
@@ -62,7 +63,17 @@ namespace numpy {
     inline const dim_type& ndim() const noexcept {
       return view.ndim;
     }
-    
+
+    // Unlike the original NumPy, strides are measured in elements, not in bytes.
+    inline const stride_type& strides() const noexcept {
+      return view.stride;
+    }
+
+    // pointer to the first element of this view (not of the underlying memory)
+    inline Dtype* data() const noexcept {
+      return memory_ptr->data.data() + view.offset;
+    }
+
     // inline const std::type_info& dtype() const{
     //   return typeid(Dtype);
     // }
@@ -537,5 +548,13 @@ namespace numpy {
     return false;
     }
   }
+
+  template <class Dtype>
+  ndarray<Dtype> as_strided(const ndarray<Dtype>& x, const shape_type& shape, const stride_type& strides) {
+    // cf) numpy.lib.stride_tricks.as_strided
+    // Creates a view into `x` with the given shape and strides (measured in elements),
+    // starting from the first element of `x`. No bounds checking is done.
+    return ndarray<Dtype>(x.memory_ptr, array_view(shape, strides, x.view.offset), x.base_ptr);
+  }
      
 }
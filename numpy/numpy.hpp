@@ -1,8 +1,12 @@
 #pragma once
 #include <numpy/ndarray.hpp>
+#include <numpy/blas.hpp>
+#include <numpy/parallel.hpp>
 #include <numpy/array_math.hpp>
+#include <numpy/einsum.hpp>
 #include <numpy/io.hpp>
 #include <numpy/algorithm.hpp>
+#include <numpy/sort.hpp>
 #include <cmath>
 #include <vector>
 #include <tuple>
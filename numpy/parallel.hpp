@@ -0,0 +1,142 @@
+// A minimal thread pool used by the multithreaded kernels.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <numpy/dtype.hpp>
+
+namespace numpy {
+
+  namespace _parallel {
+
+    inline int cpu_count() {
+      auto n = std::thread::hardware_concurrency();
+      return n == 0 ? 1 : int(n);
+    }
+
+    // Resolves a `workers` argument as in SciPy: -1 (or any non-positive value) means all the CPUs.
+    inline int num_workers(int workers) {
+      return workers <= 0 ? cpu_count() : workers;
+    }
+
+    class thread_pool {
+      std::vector<std::thread> threads;
+      std::deque<std::function<void()>> tasks;
+      std::mutex mtx;
+      std::condition_variable cv;
+      bool stop = false;
+
+      void _worker() {
+	while (true) {
+	  std::function<void()> task;
+	  {
+	    std::unique_lock<std::mutex> lock(mtx);
+	    cv.wait(lock, [this]{ return stop or not tasks.empty(); });
+	    if (stop and tasks.empty())
+	      return;
+	    task = std::move(tasks.front());
+	    tasks.pop_front();
+	  }
+	  task();
+	}
+      }
+
+    public:
+      explicit thread_pool(int n_threads) {
+	for (int i=0; i<n_threads; i++)
+	  threads.emplace_back([this]{ _worker(); });
+      }
+
+      ~thread_pool() {
+	{
+	  std::lock_guard<std::mutex> lock(mtx);
+	  stop = true;
+	}
+	cv.notify_all();
+	for (auto& t : threads)
+	  t.join();
+      }
+
+      thread_pool(const thread_pool&) = delete;
+      thread_pool& operator=(const thread_pool&) = delete;
+
+      int size() const { return threads.size(); }
+
+      void submit(std::function<void()> task) {
+	{
+	  std::lock_guard<std::mutex> lock(mtx);
+	  tasks.push_back(std::move(task));
+	}
+	cv.notify_one();
+      }
+    };
+
+    // The pool shared by all the kernels, with one thread per CPU besides the calling thread.
+    inline thread_pool& global_pool() {
+      static thread_pool pool(cpu_count() - 1);
+      return pool;
+    }
+
+    template <class Function>
+    void parallel_for(intp n_tasks, int workers, Function f) {
+      // Calls f(0), ..., f(n_tasks-1) using at most `workers` threads including the calling one.
+      // Tasks are handed out in increasing order, and the calling thread takes part in the work
+      // so that nested calls never wait for an idle worker. Serial calls never start the pool.
+      auto serial = [&] {
+	for (intp i=0; i<n_tasks; i++)
+	  f(i);
+      };
+      workers = std::min<intp>(num_workers(workers), n_tasks);
+      if (workers <= 1)
+	return serial();
+      workers = std::min<intp>(workers, global_pool().size() + 1);
+      if (workers <= 1)
+	return serial();
+
+      struct state_type {
+	std::atomic<intp> next{0};
+	intp done = 0;
+	std::exception_ptr error;
+	std::mutex mtx;
+	std::condition_variable cv;
+      };
+      auto state = std::make_shared<state_type>();
+
+      // `f` outlives every call to it since the caller waits for all the tasks to be done.
+      auto run = [state, n_tasks, &f] {
+	intp i;
+	while ((i = state->next++) < n_tasks) {
+	  std::exception_ptr error;
+	  try {
+	    f(i);
+	  } catch (...) {
+	    error = std::current_exception();
+	  }
+	  std::lock_guard<std::mutex> lock(state->mtx);
+	  if (error and not state->error)
+	    state->error = error;
+	  if (++state->done == n_tasks)
+	    state->cv.notify_all();
+	}
+      };
+      for (int w=1; w<workers; w++)
+	global_pool().submit(run);
+      run();
+
+      std::unique_lock<std::mutex> lock(state->mtx);
+      state->cv.wait(lock, [&]{ return state->done == n_tasks; });
+      if (state->error)
+	std::rethrow_exception(state->error);
+    }
+
+  }
+
+}
@@ -0,0 +1,402 @@
+// https://numpy.org/doc/stable/reference/generated/numpy.sort.html
+// https://numpy.org/doc/stable/reference/generated/numpy.argsort.html
+// https://numpy.org/doc/stable/reference/generated/numpy.partition.html
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace numpy {
+
+  namespace _sort {
+
+    struct _less {
+      // the order of NumPy, which puts NaNs last
+      template <class T>
+      bool operator()(const T& x, const T& y) const {
+	if constexpr (std::is_floating_point_v<T>)
+	  return x < y or (y != y and x == x);
+	else
+	  return x < y;
+      }
+    };
+
+    // Numbers are sorted by radix as unsigned integers of the same size, whose order is that of
+    // the numbers: the sign bit of integers is flipped, and all the bits of negative floating-point
+    // numbers, or only their sign bit if positive. NaNs are set apart beforehand.
+
+    template <class T>
+    using _radix_key = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+					  std::conditional_t<sizeof(T) == 2, std::uint16_t,
+							     std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+    template <class T>
+    constexpr bool _radix_sortable = std::is_arithmetic_v<T> and sizeof(T) <= 8;
+
+    template <class T>
+    _radix_key<T> _to_key(T x) {
+      using K = _radix_key<T>;
+      constexpr K sign = K(1) << (8*sizeof(K) - 1);
+      K k = 0;
+      std::memcpy(&k, &x, sizeof(T));
+      if constexpr (std::is_floating_point_v<T>)
+	return k & sign ? K(~k) : K(k | sign);
+      else if constexpr (std::is_signed_v<T>)
+	return k ^ sign;
+      else
+	return k;
+    }
+
+    template <class T>
+    T _from_key(_radix_key<T> k) {
+      using K = _radix_key<T>;
+      constexpr K sign = K(1) << (8*sizeof(K) - 1);
+      if constexpr (std::is_floating_point_v<T>)
+	k = k & sign ? K(k ^ sign) : K(~k);
+      else if constexpr (std::is_signed_v<T>)
+	k ^= sign;
+      T x;
+      std::memcpy(&x, &k, sizeof(T));
+      return x;
+    }
+
+    constexpr intp radix_min_size = 1 << 8; // shorter arrays are sorted by comparisons
+    constexpr intp radix_cache_size = 1 << 14; // shorter ones are sorted from their lowest byte
+
+    template <class K>
+    void _radix_sort(K* keys, K* keys_tmp, intp* idx, intp* idx_tmp, intp n, int top=sizeof(K) - 1) {
+      // Stable radix sort on the bytes 0, ..., top of the keys, permuting `idx` along unless it is
+      // null. Long arrays are split by their highest byte into buckets sorted recursively, which
+      // soon fit in cache, and those are sorted from their lowest byte, skipping the bytes shared
+      // by all the keys. Memory is thus crossed a few times rather than once per byte.
+      if (n > radix_cache_size and top > 0) {
+	std::vector<intp> start(257, 0);
+	for (intp i=0; i<n; i++)
+	  start[((keys[i] >> (8*top)) & 255) + 1]++;
+	if (std::find(start.begin() + 1, start.end(), n) != start.end())
+	  return _radix_sort(keys, keys_tmp, idx, idx_tmp, n, top - 1);
+	std::partial_sum(start.begin(), start.end(), start.begin());
+	auto pos = start;
+	for (intp i=0; i<n; i++) {
+	  auto k = pos[(keys[i] >> (8*top)) & 255]++;
+	  keys_tmp[k] = keys[i];
+	  if (idx)
+	    idx_tmp[k] = idx[i];
+	}
+	for (int d=0; d<256; d++) {
+	  auto b = start[d], e = start[d + 1];
+	  _radix_sort(keys_tmp + b, keys + b, idx ? idx_tmp + b : nullptr, idx ? idx + b : nullptr, e - b, top - 1);
+	  std::copy(keys_tmp + b, keys_tmp + e, keys + b);
+	  if (idx)
+	    std::copy(idx_tmp + b, idx_tmp + e, idx + b);
+	}
+	return;
+      }
+      if (n <= 1)
+	return;
+      std::vector<intp> count((top + 1) * 256, 0);
+      for (intp i=0; i<n; i++)
+	for (int b=0; b<=top; b++)
+	  count[b*256 + ((keys[i] >> (8*b)) & 255)]++;
+      auto src = keys, dst = keys_tmp;
+      auto isrc = idx, idst = idx_tmp;
+      for (int b=0; b<=top; b++) {
+	auto c = count.data() + b*256;
+	if (std::find(c, c + 256, n) != c + 256)
+	  continue;
+	intp pos = 0;
+	for (int d=0; d<256; d++)
+	  pos += std::exchange(c[d], pos);
+	for (intp i=0; i<n; i++) {
+	  auto k = c[(src[i] >> (8*b)) & 255]++;
+	  dst[k] = src[i];
+	  if (idx)
+	    idst[k] = isrc[i];
+	}
+	std::swap(src, dst);
+	std::swap(isrc, idst);
+      }
+      if (src != keys) {
+	std::copy(src, src + n, keys);
+	if (idx)
+	  std::copy(isrc, isrc + n, idx);
+      }
+    }
+
+    template <class K>
+    intp _co_rank(intp k, const K* a, intp na, const K* b, intp nb) {
+      // the number of elements of `a` among the first k of the stable merge of a and b
+      auto lo = std::max(intp(0), k - nb), hi = std::min(k, na);
+      while (lo < hi) {
+	auto i = (lo + hi) / 2;
+	if (b[k - i - 1] < a[i])
+	  hi = i;
+	else
+	  lo = i + 1;
+      }
+      return lo;
+    }
+
+    template <class K>
+    void _merge(const K* a, const intp* ia, intp na, const K* b, const intp* ib, intp nb, K* out, intp* iout) {
+      // stable merge, taking from `a` first on ties, of indices too unless they are null
+      intp i = 0, j = 0, k = 0;
+      while (i < na and j < nb) {
+	bool take_b = b[j] < a[i];
+	out[k] = take_b ? b[j] : a[i];
+	if (iout)
+	  iout[k] = take_b ? ib[j] : ia[i];
+	j += take_b;
+	i += not take_b;
+	k++;
+      }
+      std::copy(a + i, a + na, out + k);
+      std::copy(b + j, b + nb, out + k + na - i);
+      if (iout) {
+	std::copy(ia + i, ia + na, iout + k);
+	std::copy(ib + j, ib + nb, iout + k + na - i);
+      }
+    }
+
+    template <class K>
+    void _sort_keys(K* keys, intp* idx, intp n, int workers) {
+      // Stable sort of the keys, permuting `idx` along unless it is null. Large arrays are split
+      // into a power of two of chunks sorted by `workers` threads, then merged pairwise in rounds
+      // whose merges are split among the threads at co-ranks, so that every step is parallel.
+      std::vector<K> keys_tmp(n);
+      std::vector<intp> idx_tmp(idx ? n : 0);
+      workers = n < _reduction::parallel_min_size ? 1 : _parallel::num_workers(workers);
+      intp chunks = 1;
+      while (chunks < workers)
+	chunks *= 2;
+      auto bound = [&](intp c) { return n * c / chunks; };
+      _parallel::parallel_for(chunks, workers, [&](intp c) {
+	auto b = bound(c);
+	_radix_sort(keys + b, keys_tmp.data() + b, idx ? idx + b : nullptr, idx ? idx_tmp.data() + b : nullptr,
+		    bound(c + 1) - b);
+      });
+      auto src = keys, dst = keys_tmp.data();
+      auto isrc = idx, idst = idx ? idx_tmp.data() : nullptr;
+      for (intp width=1; width<chunks; width*=2) {
+	auto pairs = chunks / (2 * width), parts = std::max(intp(1), workers / pairs);
+	_parallel::parallel_for(pairs * parts, workers, [&](intp t) {
+	  auto p = t / parts, q = t % parts;
+	  auto b = bound(2*width*p), m = bound(2*width*p + width), e = bound(2*width*(p + 1));
+	  auto k0 = (e - b) * q / parts, k1 = (e - b) * (q + 1) / parts;
+	  auto i0 = _co_rank(k0, src + b, m - b, src + m, e - m), i1 = _co_rank(k1, src + b, m - b, src + m, e - m);
+	  _merge(src + b + i0, idx ? isrc + b + i0 : nullptr, i1 - i0,
+		 src + m + k0 - i0, idx ? isrc + m + k0 - i0 : nullptr, (k1 - i1) - (k0 - i0),
+		 dst + b + k0, idx ? idst + b + k0 : nullptr);
+	});
+	std::swap(src, dst);
+	std::swap(isrc, idst);
+      }
+      if (src != keys) {
+	std::copy(src, src + n, keys);
+	if (idx)
+	  std::copy(isrc, isrc + n, idx);
+      }
+    }
+
+    template <class Dtype>
+    void _sort_run(Dtype* x, intp n, int workers) {
+      // in place, NaNs last
+      intp m = n;
+      if constexpr (std::is_floating_point_v<Dtype>)
+	m = std::partition(x, x + n, [](Dtype v) { return v == v; }) - x;
+      if constexpr (_radix_sortable<Dtype>)
+	if (m >= radix_min_size) {
+	  std::vector<_radix_key<Dtype>> keys(m);
+	  std::transform(x, x + m, keys.begin(), _to_key<Dtype>);
+	  _sort_keys(keys.data(), static_cast<intp*>(nullptr), m, workers);
+	  std::transform(keys.begin(), keys.end(), x, _from_key<Dtype>);
+	  return;
+	}
+      std::sort(x, x + m, _less());
+    }
+
+    template <class Dtype>
+    void _argsort_run(const Dtype* x, intp n, intp* idx, int workers) {
+      // the indices that sort x stably, NaNs last
+      intp m = n;
+      if constexpr (std::is_floating_point_v<Dtype>) {
+	m = 0;
+	for (intp i=0; i<n; i++)
+	  if (x[i] == x[i])
+	    idx[m++] = i;
+	for (intp i=0, k=m; i<n; i++)
+	  if (x[i] != x[i])
+	    idx[k++] = i;
+      } else {
+	std::iota(idx, idx + n, intp(0));
+      }
+      if constexpr (_radix_sortable<Dtype>)
+	if (m >= radix_min_size) {
+	  std::vector<_radix_key<Dtype>> keys(m);
+	  for (intp i=0; i<m; i++)
+	    keys[i] = _to_key(Dtype(x[idx[i]] + Dtype(0))); // -0.0 and 0.0 tie
+	  _sort_keys(keys.data(), idx, m, workers);
+	  return;
+	}
+      std::stable_sort(idx, idx + m, [x](intp i, intp j) { return _less()(x[i], x[j]); });
+    }
+
+    inline std::vector<intp> _normalize_kth(const std::vector<intp>& kth, intp n) {
+      std::vector<intp> ret;
+      for (auto k : kth) {
+	if (k < -n or k >= n)
+	  throw std::invalid_argument("ValueError: kth(=" + python::str(k) + ") out of bounds (" + python::str(n) + ")");
+	ret.push_back(k < 0 ? k + n : k);
+      }
+      std::sort(ret.begin(), ret.end());
+      ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+      return ret;
+    }
+
+    template <class T, class Compare>
+    void _select(T* x, intp n, const std::vector<intp>& kth, Compare comp) {
+      // Puts the kth smallest elements in place, the smaller ones before and the others after, by
+      // introselect on the part left by the previous kth.
+      intp lo = 0;
+      for (auto k : kth) {
+	std::nth_element(x + lo, x + k, x + n, comp);
+	lo = k + 1;
+      }
+    }
+
+    template <class Out, class Dtype, class Function>
+    ndarray<Out> _along_axis(const ndarray<Dtype>& a, axis_type axis, int workers, Function f) {
+      // An array of the shape of `a` whose fibers y along `axis` are filled by f(x, n, y, workers)
+      // from those x of `a`, both contiguous. Strided fibers go through buffers. Many fibers are
+      // shared among `workers` threads, while a single one gets them all.
+      axis = _normalize_axes({axis}, a.ndim())[0];
+      auto out = empty<Out>(a.shape());
+      if (out.size() == 0)
+	return out;
+      auto n = a.shape(axis);
+      auto xs = a.strides()[axis], ys = out.strides()[axis];
+      auto fibers = [&](const stride_type& strides) {
+	shape_type sub_shape;
+	stride_type sub_strides;
+	for (axis_type ax=0; ax<a.ndim(); ax++)
+	  if (ax != axis) {
+	    sub_shape.push_back(a.shape(ax));
+	    sub_strides.push_back(strides[ax]);
+	  }
+	std::vector<intp> offsets;
+	_reduction::_for_each_offset(sub_shape, sub_strides, 0, sub_shape.size(), [&](intp offset) {
+	  offsets.push_back(offset);
+	});
+	return offsets;
+      };
+      auto x_offsets = fibers(a.strides()), y_offsets = fibers(out.strides());
+      intp n_fibers = x_offsets.size();
+      workers = a.size() < _reduction::parallel_min_size ? 1 : _parallel::num_workers(workers);
+      intp n_tasks = std::min<intp>(n_fibers, 4 * workers);
+      _parallel::parallel_for(n_tasks, workers, [&](intp t) {
+	std::vector<Dtype> x_buffer(xs == 1 ? 0 : n);
+	std::vector<Out> y_buffer(ys == 1 ? 0 : n);
+	for (auto i=n_fibers*t/n_tasks; i<n_fibers*(t + 1)/n_tasks; i++) {
+	  const Dtype* x = a.data() + x_offsets[i];
+	  auto y = out.data() + y_offsets[i];
+	  if (xs != 1) {
+	    for (intp j=0; j<n; j++)
+	      x_buffer[j] = x[j*xs];
+	    x = x_buffer.data();
+	  }
+	  f(x, n, ys == 1 ? y : y_buffer.data(), n_fibers == 1 ? workers : 1);
+	  if (ys != 1)
+	    for (intp j=0; j<n; j++)
+	      y[j*ys] = y_buffer[j];
+	}
+      });
+      return out;
+    }
+
+    template <class Dtype>
+    ndarray<Dtype> _flatten(const ndarray<Dtype>& a) {
+      auto ret = empty<Dtype>({a.size()});
+      auto p = ret.data();
+      _reduction::_for_each_run(a, [&](const Dtype* x, intp n, intp stride) {
+	for (intp j=0; j<n; j++)
+	  *p++ = x[j*stride];
+      });
+      return ret;
+    }
+
+  }
+
+  // Sorting and selection along an axis, NaNs last. Numbers are sorted by radix, large arrays by
+  // `workers` threads (-1 for all the CPUs) with parallel merges, and selections use introselect.
+
+  template <class Dtype>
+  ndarray<Dtype> sort(const ndarray<Dtype>& a, axis_type axis=-1, int workers=-1) {
+    return _sort::_along_axis<Dtype>(a, axis, workers, [](const Dtype* x, intp n, Dtype* y, int workers) {
+      std::copy(x, x + n, y);
+      _sort::_sort_run(y, n, workers);
+    });
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> sort(const ndarray<Dtype>& a, python::NoneType axis, int workers=-1) {
+    // the flattened array sorted
+    return sort(_sort::_flatten(a), -1, workers);
+  }
+
+  template <class Dtype>
+  ndarray<intp> argsort(const ndarray<Dtype>& a, axis_type axis=-1, int workers=-1) {
+    // the indices that sort `a` along `axis`, equal elements keeping their order
+    return _sort::_along_axis<intp>(a, axis, workers, [](const Dtype* x, intp n, intp* y, int workers) {
+      _sort::_argsort_run(x, n, y, workers);
+    });
+  }
+
+  template <class Dtype>
+  ndarray<intp> argsort(const ndarray<Dtype>& a, python::NoneType axis, int workers=-1) {
+    // the indices that sort the flattened array
+    return argsort(_sort::_flatten(a), -1, workers);
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> partition(const ndarray<Dtype>& a, const std::vector<intp>& kth, axis_type axis=-1, int workers=-1) {
+    // a copy of `a` whose kth elements along `axis` are those of the sorted array, with no larger
+    // ones before and no smaller ones after
+    auto ks = _sort::_normalize_kth(kth, a.shape(_normalize_axes({axis}, a.ndim())[0]));
+    return _sort::_along_axis<Dtype>(a, axis, workers, [&ks](const Dtype* x, intp n, Dtype* y, int) {
+      std::copy(x, x + n, y);
+      _sort::_select(y, n, ks, _sort::_less());
+    });
+  }
+
+  template <class Dtype>
+  ndarray<Dtype> partition(const ndarray<Dtype>& a, intp kth, axis_type axis=-1, int workers=-1) {
+    return partition(a, std::vector<intp>{kth}, axis, workers);
+  }
+
+  template <class Dtype>
+  ndarray<intp> argpartition(const ndarray<Dtype>& a, const std::vector<intp>& kth, axis_type axis=-1, int workers=-1) {
+    // the indices that partition `a` along `axis`, as partition does
+    auto ks = _sort::_normalize_kth(kth, a.shape(_normalize_axes({axis}, a.ndim())[0]));
+    return _sort::_along_axis<intp>(a, axis, workers, [&ks](const Dtype* x, intp n, intp* y, int) {
+      // the values move with their indices, which keeps the selection in cache
+      std::vector<std::pair<Dtype, intp>> items(n);
+      for (intp j=0; j<n; j++)
+	items[j] = {x[j], j};
+      _sort::_select(items.data(), n, ks, [](const auto& u, const auto& v) { return _sort::_less()(u.first, v.first); });
+      for (intp j=0; j<n; j++)
+	y[j] = items[j].second;
+    });
+  }
+
+  template <class Dtype>
+  ndarray<intp> argpartition(const ndarray<Dtype>& a, intp kth, axis_type axis=-1, int workers=-1) {
+    return argpartition(a, std::vector<intp>{kth}, axis, workers);
+  }
+
+}
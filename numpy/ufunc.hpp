@@ -10,6 +10,10 @@ namespace numpy {
   template <class Dtype> class ndarray;
   template <class Dtype> ndarray<Dtype> empty(const shape_type& shape);
 
+  namespace _ufunc_internal {
+    template <class Type1, class Type2> struct _add;
+  }
+
   class ufunc {
   /**
    * https://numpy.org/doc/stable/reference/ufuncs.html 
@@ -140,6 +144,17 @@ namespace numpy {
       return out;
     }
 
+    template <class Type>
+    auto reduce(const ndarray<Type>& array, axis_type axis=0) const {
+      // Reduces `array` along `axis` by the operation, as NumPy's ufunc.reduce. add.reduce is
+      // the pairwise sum; other operations are applied in order along the axis.
+      if constexpr (std::is_same_v<BinaryOperation<Type, Type>, _ufunc_internal::_add<Type, Type>>) {
+	return sum(array, axis);
+      } else {
+	return _fold_axis(array, axis, BinaryOperation<Type, Type>());
+      }
+    }
+
     template <class Type1, class Type2, class... Args>
     auto operator()(const Type1& x1, const Type2& x2, const Args&... args) const
       ->typename std::enable_if<isscolar<Type2>(),//std::is_arithmetic<Type2>::value,
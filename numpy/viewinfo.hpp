@@ -20,6 +20,7 @@ namespace numpy {
     template <class Dtype> friend class array_iter;
     template <template <class> class UnaryOperation> friend struct ufunc_unary;
     template <template <class, class> class BinaryOperation> friend struct ufunc_binary;
+    template <class Dtype> friend ndarray<Dtype> as_strided(const ndarray<Dtype>& x, const shape_type& shape, const stride_type& strides);
     
     shape_type shape;
     dim_type ndim;
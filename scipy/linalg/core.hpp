@@ -18,14 +18,83 @@ namespace scipy {
 
     constexpr np::float_ eps_default = 5.0e-15;
 
+    // y = A x for a linear operator of order n given as a function, x and y holding n elements
+    template <class Dtype>
+    using matvec_type = std::function<void(const Dtype* x, Dtype* y)>;
+
+    template <class Dtype>
+    struct LinearOperator {
+      // A square operator known by its action y = A x only, as SciPy's LinearOperator, so that
+      // stencils or FFT-based operators are never stored. Optionally, `diagonal` gives A(i, i)
+      // and `row_dot` gives (A x)(i) alone, which the stationary iterative methods need.
+      np::shape_type shape;
+      matvec_type<Dtype> matvec;
+      std::function<Dtype(np::intp i)> diagonal;
+      std::function<Dtype(np::intp i, const Dtype* x)> row_dot;
+
+      LinearOperator() : shape{0, 0} {}
+
+      LinearOperator(const np::shape_type& shape_, const matvec_type<Dtype>& matvec_,
+		     const std::function<Dtype(np::intp)>& diagonal_=nullptr,
+		     const std::function<Dtype(np::intp, const Dtype*)>& row_dot_=nullptr)
+	: shape(shape_), matvec(matvec_), diagonal(diagonal_), row_dot(row_dot_) {
+	if (shape.size() != 2 or shape[0] != shape[1])
+	  throw std::invalid_argument("ValueError: expected a square operator");
+      }
+
+      LinearOperator(const matrix<Dtype>& a) {
+	// a dense matrix, which is shared and not copied
+	if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	  throw std::invalid_argument("ValueError: expected square matrix");
+	shape = a.shape();
+	auto n = a.shape(0), rs = a.strides()[0], cs = a.strides()[1];
+	matvec = [a, n, rs, cs](const Dtype* x, Dtype* y) {
+	  np::_blas::gemv(n, n, Dtype(1), a.data(), rs, cs, x, np::intp(1), Dtype(0), y, np::intp(1));
+	};
+	diagonal = [a, rs, cs](np::intp i) { return a.data()[i*(rs + cs)]; };
+	row_dot = [a, n, rs, cs](np::intp i, const Dtype* x) {
+	  return np::_blas::dot<Dtype>(n, a.data() + i*rs, cs, x, 1);
+	};
+      }
+
+      LinearOperator(const sparse::spmatrix<Dtype>& a, int workers=-1) {
+	// a sparse matrix, converted to CSR once, whose products use `workers` threads
+	auto csr = a.tocsr();
+	if (csr.shape[0] != csr.shape[1])
+	  throw std::invalid_argument("ValueError: expected square matrix");
+	shape = csr.shape;
+	auto d = csr.diagonal();
+	matvec = [csr, workers](const Dtype* x, Dtype* y) { csr._matvec(x, y, workers); };
+	diagonal = [d](np::intp i) { return d.data()[i]; };
+	row_dot = [csr](np::intp i, const Dtype* x) { return csr._row_dot(i, x); };
+      }
+    };
+
+    template <class Dtype>
+    LinearOperator<Dtype> aslinearoperator(const matrix<Dtype>& a) {
+      return LinearOperator<Dtype>(a);
+    }
+
+    template <class Dtype>
+    LinearOperator<Dtype> aslinearoperator(const sparse::spmatrix<Dtype>& a, int workers=-1) {
+      return LinearOperator<Dtype>(a, workers);
+    }
+
     template <class ArrayLike>
     auto norm(const ArrayLike& x, int ord=2) -> np::float64 {
+      // summed as np::sum, by all the CPUs for large arrays with the same result for any number of them
+      auto method = np::summation::pairwise;
       if (ord == 1)
-	return np::sum(np::absolute(x));
+	return np::_reduction::_sum<np::float64>(x, method, -1, [](auto v) { return np::float64(std::abs(v)); });
       if (ord == 2)
-	return std::sqrt(std::inner_product(x.begin(), x.end(), x.begin(), np::float_(0)));
+	return std::sqrt(np::_reduction::_sum<np::float64>(x, method, -1, [](auto v) {
+	  auto abs_v = np::float64(std::abs(v));
+	  return abs_v * abs_v;
+	}));
       else
-	return std::pow(np::sum(np::power(np::absolute(x), ord)), 1.0/ord);
+	return std::pow(np::_reduction::_sum<np::float64>(x, method, -1, [ord](auto v) {
+	  return std::pow(np::float64(std::abs(v)), ord);
+	}), 1.0/ord);
     }
     
   }
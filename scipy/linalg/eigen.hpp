@@ -16,8 +16,16 @@ namespace scipy {
 	np::float_ eps;
 
 	bool _converge(const vector<Dtype>& eigvec_new) const {
-	  auto err = norm(eigvec_new - eigval*eigvec);
-	  return err < eps; 
+	  // norm(eigvec_new - eigval*eigvec) < eps without temporaries
+	  auto n = eigvec.shape(0);
+	  auto x = eigvec.data(), y = eigvec_new.data();
+	  auto incx = eigvec.strides()[0], incy = eigvec_new.strides()[0];
+	  np::float_ err = 0;
+	  for (np::intp i=0; i<n; i++) {
+	    auto r = y[i*incy] - eigval * x[i*incx];
+	    err += r * r;
+	  }
+	  return std::sqrt(err) < eps;
 	}
 
 	virtual vector<Dtype> _update_eigvec() const {
@@ -29,7 +37,7 @@ namespace scipy {
 	    auto eigvec_new = this->_update_eigvec();
 	    if (_converge(eigvec_new))
 	      break;
-	    eigval = np::dot(eigvec, eigvec_new); // Rayleigh quotient
+	    eigval = np::vdot(eigvec, eigvec_new); // Rayleigh quotient
 	    eigvec = eigvec_new;
 	    eigvec /= norm(eigvec);
 	  }
@@ -87,7 +95,7 @@ namespace scipy {
 	  
 	  for (int k=j+1; k<n; k++) {
 	    auto Q_k = Q(k);
-	    auto R_kj = np::dot(Q_k, Q_j);
+	    auto R_kj = np::vdot(Q_k, Q_j);
 	    
 	    R(k, j) = R_kj;
 	    Q_k -= R_kj * Q_j;
@@ -97,6 +105,802 @@ namespace scipy {
 	return {Q.T(), R.T()};
       }
 
+
+      // Hessenberg reduction & Francis double-shift QR
+
+      template <class Dtype>
+      void _balance(Dtype* a, np::intp rs, np::intp cs, np::intp n, Dtype* scale) {
+	// Balances the rows and columns of A by powers of 2 as a similarity transform
+	// A <- D^-1 A D, which improves the accuracy of the eigenvalues. D is stored in `scale`.
+	constexpr Dtype radix = 2;
+	std::fill(scale, scale + n, Dtype(1));
+	bool done = false;
+	while (not done) {
+	  done = true;
+	  for (np::intp i=0; i<n; i++) {
+	    Dtype c = 0, r = 0;
+	    for (np::intp j=0; j<n; j++)
+	      if (j != i) {
+		c += std::abs(a[j*rs + i*cs]);
+		r += std::abs(a[i*rs + j*cs]);
+	      }
+	    if (c == Dtype(0) or r == Dtype(0))
+	      continue;
+	    auto g = r / radix, f = Dtype(1), s = c + r;
+	    while (c < g) {
+	      f *= radix;
+	      c *= radix * radix;
+	    }
+	    g = r * radix;
+	    while (c > g) {
+	      f /= radix;
+	      c /= radix * radix;
+	    }
+	    if ((c + r) / f < Dtype(0.95) * s) {
+	      done = false;
+	      scale[i] *= f;
+	      np::_blas::scal(n, Dtype(1) / f, a + i*rs, cs);
+	      np::_blas::scal(n, f, a + i*cs, rs);
+	    }
+	  }
+	}
+      }
+
+      template <class Dtype>
+      void _hessenberg_reduce(Dtype* a, np::intp rs, np::intp cs, np::intp n, Dtype* tau) {
+	// Reduces A to the upper Hessenberg form H = Q^T A Q with Householder reflectors in-place.
+	// As with LAPACK's gehrd, the reflector k is stored below the first subdiagonal of the column k.
+	std::vector<Dtype> v(n), w(n);
+	for (np::intp k=0; k+1<n; k++) {
+	  auto m = n - k - 1;
+	  auto a_k = a + (k+1)*rs + k*cs;
+	  tau[k] = _qr::_householder(m, a_k, rs);
+	  if (tau[k] == Dtype(0))
+	    continue;
+	  v[0] = Dtype(1);
+	  for (np::intp i=1; i<m; i++)
+	    v[i] = a_k[i*rs];
+
+	  // A(k+1:, k+1:) <- H A(k+1:, k+1:)
+	  auto a_kk = a + (k+1)*rs + (k+1)*cs;
+	  std::fill(w.begin(), w.begin() + m, Dtype(0));
+	  for (np::intp i=0; i<m; i++)
+	    np::_blas::axpy(m, v[i], a_kk + i*rs, cs, w.data(), 1);
+	  for (np::intp i=0; i<m; i++)
+	    np::_blas::axpy(m, -tau[k] * v[i], w.data(), 1, a_kk + i*rs, cs);
+
+	  // A(:, k+1:) <- A(:, k+1:) H
+	  for (np::intp i=0; i<n; i++) {
+	    auto a_i = a + i*rs + (k+1)*cs;
+	    auto s = np::_blas::dot<Dtype>(m, a_i, cs, v.data(), 1);
+	    np::_blas::axpy(m, -tau[k] * s, v.data(), 1, a_i, cs);
+	  }
+	}
+      }
+
+      template <class Dtype>
+      struct Hessenberg_decomposition {
+
+	matrix<Dtype> h; // H on and above the first subdiagonal and the Householder vectors below it
+	vector<Dtype> tau;
+
+	Hessenberg_decomposition(const matrix<Dtype>& a, bool overwrite_a=false) {
+	  static_assert(std::is_floating_point_v<Dtype>);
+	  if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	    throw std::invalid_argument("ValueError: expected square matrix");
+	  if (overwrite_a)
+	    h = a;
+	  else
+	    h = a.copy();
+	  auto n = h.shape(0);
+	  tau = np::zeros<Dtype>({std::max<np::intp>(n - 1, 0)});
+	  _hessenberg_reduce(h.data(), h.strides()[0], h.strides()[1], n, tau.data());
+	}
+
+	matrix<Dtype> H() const {
+	  auto n = h.shape(0);
+	  auto ret = np::zeros<Dtype>({n, n});
+	  auto rs = h.strides()[0], cs = h.strides()[1];
+	  for (np::intp i=0; i<n; i++)
+	    for (np::intp j=std::max<np::intp>(i-1, 0); j<n; j++)
+	      ret.data()[i*n + j] = h.data()[i*rs + j*cs];
+	  return ret;
+	}
+
+	matrix<Dtype> Q() const {
+	  // The reflectors are laid out as those of the QR decomposition of A(1:, :-1).
+	  auto n = h.shape(0);
+	  auto ret = np::identity(n).template astype<Dtype>();
+	  if (n > 1) {
+	    auto rs = h.strides()[0], cs = h.strides()[1];
+	    _qr::_qr_apply_q(false, h.data() + rs, rs, cs, n - 1, n - 1, tau.data(),
+			     ret.data() + n + 1, n, np::intp(1), n - 1);
+	  }
+	  return ret;
+	}
+      };
+
+      template <class Dtype>
+      void _hessenberg_qr(Dtype* a, np::intp rs, np::intp cs, np::intp n, std::complex<Dtype>* w) {
+	// Computes the eigenvalues of an upper Hessenberg matrix with the implicitly shifted
+	// Francis double-shift QR algorithm, destroying it.
+	// Negligible subdiagonal elements are searched for in the whole active block at every sweep,
+	// so that it splits (deflates) as early as possible, and each sweep costs O(n^2) at most.
+	// Exceptional shifts are tried after 10 and 20 sweeps without deflation.
+	auto A = [a, rs, cs](np::intp i, np::intp j) -> Dtype& { return a[i*rs + j*cs]; };
+	const auto eps = std::numeric_limits<Dtype>::epsilon();
+
+	Dtype anorm = 0;
+	for (np::intp i=0; i<n; i++)
+	  for (np::intp j=std::max<np::intp>(i-1, 0); j<n; j++)
+	    anorm += std::abs(A(i, j));
+
+	np::intp nn = n - 1, l = 0;
+	Dtype t = 0;
+	Dtype p = 0, q = 0, r = 0, s, x, y, z, ww;
+	while (nn >= 0) {
+	  int its = 0;
+	  do {
+	    // look for a single small subdiagonal element
+	    for (l=nn; l>=1; l--) {
+	      s = std::abs(A(l-1, l-1)) + std::abs(A(l, l));
+	      if (s == Dtype(0))
+		s = anorm;
+	      if (std::abs(A(l, l-1)) <= eps * s) {
+		A(l, l-1) = Dtype(0);
+		break;
+	      }
+	    }
+	    x = A(nn, nn);
+	    if (l == nn) { // one root found
+	      w[nn--] = x + t;
+	      continue;
+	    }
+	    y = A(nn-1, nn-1);
+	    ww = A(nn, nn-1) * A(nn-1, nn);
+	    if (l == nn - 1) { // two roots found
+	      p = Dtype(0.5) * (y - x);
+	      q = p * p + ww;
+	      z = std::sqrt(std::abs(q));
+	      x += t;
+	      if (q >= Dtype(0)) { // a real pair
+		z = p + std::copysign(z, p);
+		w[nn-1] = w[nn] = x + z;
+		if (z != Dtype(0))
+		  w[nn] = x - ww / z;
+	      } else { // a complex pair
+		w[nn-1] = {x + p, z};
+		w[nn] = {x + p, -z};
+	      }
+	      nn -= 2;
+	      continue;
+	    }
+
+	    // no roots found yet
+	    if (its == 30)
+	      throw std::runtime_error("LinAlgError: eig algorithm did not converge");
+	    if (its == 10 or its == 20) { // exceptional shift
+	      t += x;
+	      for (np::intp i=0; i<=nn; i++)
+		A(i, i) -= x;
+	      s = std::abs(A(nn, nn-1)) + std::abs(A(nn-1, nn-2));
+	      y = x = Dtype(0.75) * s;
+	      ww = Dtype(-0.4375) * s * s;
+	    }
+	    ++its;
+
+	    // form the shift and look for two consecutive small subdiagonal elements
+	    np::intp m;
+	    for (m=nn-2; m>=l; m--) {
+	      z = A(m, m);
+	      r = x - z;
+	      s = y - z;
+	      p = (r * s - ww) / A(m+1, m) + A(m, m+1);
+	      q = A(m+1, m+1) - z - r - s;
+	      r = A(m+2, m+1);
+	      s = std::abs(p) + std::abs(q) + std::abs(r);
+	      p /= s;
+	      q /= s;
+	      r /= s;
+	      if (m == l)
+		break;
+	      auto u = std::abs(A(m, m-1)) * (std::abs(q) + std::abs(r));
+	      auto v = std::abs(p) * (std::abs(A(m-1, m-1)) + std::abs(z) + std::abs(A(m+1, m+1)));
+	      if (u <= eps * v)
+		break;
+	    }
+	    for (np::intp i=m+2; i<=nn; i++) {
+	      A(i, i-2) = Dtype(0);
+	      if (i != m + 2)
+		A(i, i-3) = Dtype(0);
+	    }
+
+	    // double QR step on rows l to nn and columns m to nn, chasing the bulge
+	    for (np::intp k=m; k<=nn-1; k++) {
+	      if (k != m) {
+		p = A(k, k-1);
+		q = A(k+1, k-1);
+		r = (k != nn - 1) ? A(k+2, k-1) : Dtype(0);
+		if ((x = std::abs(p) + std::abs(q) + std::abs(r)) != Dtype(0)) {
+		  p /= x;
+		  q /= x;
+		  r /= x;
+		}
+	      }
+	      if ((s = std::copysign(std::sqrt(p*p + q*q + r*r), p)) == Dtype(0))
+		continue;
+	      if (k == m) {
+		if (l != m)
+		  A(k, k-1) = -A(k, k-1);
+	      } else
+		A(k, k-1) = -s * x;
+	      p += s;
+	      x = p / s;
+	      y = q / s;
+	      z = r / s;
+	      q /= p;
+	      r /= p;
+	      for (np::intp j=k; j<=nn; j++) { // row modification
+		p = A(k, j) + q * A(k+1, j);
+		if (k != nn - 1) {
+		  p += r * A(k+2, j);
+		  A(k+2, j) -= p * z;
+		}
+		A(k+1, j) -= p * y;
+		A(k, j) -= p * x;
+	      }
+	      auto i_max = std::min(nn, k + 3);
+	      for (np::intp i=l; i<=i_max; i++) { // column modification
+		p = x * A(i, k) + y * A(i, k+1);
+		if (k != nn - 1) {
+		  p += z * A(i, k+2);
+		  A(i, k+2) -= p * r;
+		}
+		A(i, k+1) -= p * q;
+		A(i, k) -= p;
+	      }
+	    }
+	  } while (l < nn - 1);
+	}
+      }
+
+      template <class Dtype>
+      void _apply_reflectors(const Dtype* a, np::intp rs, np::intp cs, np::intp n, const Dtype* tau, Dtype* x, np::intp incx) {
+	// x <- Q x for the reflectors stored by _hessenberg_reduce or _tridiagonalize, one by one in O(n^2)
+	for (np::intp k=n-2; k>=0; k--) {
+	  if (tau[k] == Dtype(0))
+	    continue;
+	  auto v = a + (k+2)*rs + k*cs; // v(1:), v(0) = 1
+	  auto x_k = x + (k+1)*incx;
+	  auto m = n - k - 2;
+	  auto s = tau[k] * (x_k[0] + np::_blas::dot<Dtype>(m, v, rs, x_k + incx, incx));
+	  x_k[0] -= s;
+	  np::_blas::axpy(m, -s, v, rs, x_k + incx, incx);
+	}
+      }
+
+      template <class Dtype>
+      void _hessenberg_inverse_iteration(const Dtype* h, np::intp rs, np::intp cs, np::intp n, Dtype shift,
+					 Dtype* x, np::float_ eps, int max_iter=50) {
+	// An eigenvector of the upper Hessenberg matrix H for the eigenvalue `shift` into x, by inverse
+	// iteration. H - shift I is factorized once with partial pivoting, which costs O(n^2)
+	// since only the subdiagonal has to be eliminated, and so does each iteration.
+	std::vector<Dtype> u(n * n, Dtype(0)), l(n), y(n);
+	std::vector<bool> swapped(n);
+	Dtype h_norm = 0;
+	for (np::intp i=0; i<n; i++) {
+	  Dtype row_sum = 0;
+	  for (np::intp j=std::max<np::intp>(i-1, 0); j<n; j++) {
+	    u[i*n + j] = h[i*rs + j*cs] - (i == j ? shift : Dtype(0));
+	    row_sum += std::abs(h[i*rs + j*cs]);
+	  }
+	  h_norm = std::max(h_norm, row_sum);
+	}
+	auto tiny = std::numeric_limits<Dtype>::epsilon() * std::max(h_norm, std::numeric_limits<Dtype>::min());
+
+	for (np::intp j=0; j+1<n; j++) {
+	  auto u_j = u.data() + j*n, u_j1 = u_j + n;
+	  if (std::abs(u_j1[j]) > std::abs(u_j[j])) {
+	    std::swap_ranges(u_j + j, u_j + n, u_j1 + j);
+	    swapped[j] = true;
+	  }
+	  if (u_j[j] == Dtype(0)) // singular, as expected for an exact eigenvalue
+	    u_j[j] = tiny;
+	  l[j] = u_j1[j] / u_j[j];
+	  np::_blas::axpy(n - j - 1, -l[j], u_j + j + 1, 1, u_j1 + j + 1, 1);
+	}
+	if (n > 0 and u[n*n - 1] == Dtype(0))
+	  u[n*n - 1] = tiny;
+
+	std::fill(x, x + n, Dtype(1) / std::sqrt(Dtype(n)));
+	for (int iter=0; iter<max_iter; iter++) {
+	  std::copy(x, x + n, y.begin());
+	  for (np::intp j=0; j+1<n; j++) {
+	    if (swapped[j])
+	      std::swap(y[j], y[j+1]);
+	    y[j+1] -= l[j] * y[j];
+	  }
+	  for (np::intp i=n-1; i>=0; i--)
+	    y[i] = (y[i] - np::_blas::dot<Dtype>(n - i - 1, u.data() + i*n + i + 1, 1, y.data() + i + 1, 1)) / u[i*n + i];
+	  auto scale = Dtype(1) / np::_blas::nrm2(n, y.data(), 1);
+	  if (np::_blas::dot<Dtype>(n, y.data(), 1, x, 1) < 0)
+	    scale = -scale;
+	  Dtype diff = 0;
+	  for (np::intp i=0; i<n; i++) {
+	    y[i] *= scale;
+	    diff = std::max(diff, std::abs(y[i] - x[i]));
+	    x[i] = y[i];
+	  }
+	  if (diff < eps)
+	    break;
+	}
+      }
+
+      template <class Dtype>
+      vector<std::complex<Dtype>> _eigvals_general(matrix<Dtype>& a) {
+	// balancing, Hessenberg reduction and the Francis QR algorithm, overwriting `a`
+	auto n = a.shape(0);
+	auto rs = a.strides()[0], cs = a.strides()[1];
+	std::vector<Dtype> work(std::max<np::intp>(n, 1));
+	_balance(a.data(), rs, cs, n, work.data());
+	_hessenberg_reduce(a.data(), rs, cs, n, work.data());
+	auto w = np::zeros<std::complex<Dtype>>({n});
+	_hessenberg_qr(a.data(), rs, cs, n, w.data());
+	return w;
+      }
+
+
+      // symmetric eigenproblem: tridiagonalization & divide-and-conquer
+
+      template <class Dtype>
+      void _tridiagonalize(Dtype* a, np::intp rs, np::intp cs, np::intp n, Dtype* d, Dtype* e, Dtype* tau) {
+	// Reduces a symmetric A to the tridiagonal form T = Q^T A Q with Householder reflectors,
+	// referencing and updating its lower triangle only (LAPACK's sytrd).
+	// The reflectors are stored as in _hessenberg_reduce.
+	std::vector<Dtype> v(n), p(n);
+	for (np::intp k=0; k+1<n; k++) {
+	  auto m = n - k - 1;
+	  auto a_k = a + (k+1)*rs + k*cs;
+	  d[k] = a[k*rs + k*cs];
+	  tau[k] = _qr::_householder(m, a_k, rs);
+	  e[k] = a_k[0];
+	  if (tau[k] == Dtype(0))
+	    continue;
+	  v[0] = Dtype(1);
+	  for (np::intp i=1; i<m; i++)
+	    v[i] = a_k[i*rs];
+
+	  // p = tau A22 v from the lower triangle of A22 = A(k+1:, k+1:)
+	  auto a22 = a + (k+1)*rs + (k+1)*cs;
+	  std::fill(p.begin(), p.begin() + m, Dtype(0));
+	  for (np::intp i=0; i<m; i++) {
+	    auto a_i = a22 + i*rs;
+	    p[i] += np::_blas::dot<Dtype>(i + 1, a_i, cs, v.data(), 1);
+	    // the upper triangle by symmetry: p(:i) += v(i) A22(i, :i)
+	    for (np::intp j=0; j<i; j++)
+	      p[j] += v[i] * a_i[j*cs];
+	  }
+	  np::_blas::scal(m, tau[k], p.data(), 1);
+	  // w = p - tau/2 (p.v) v and A22 <- A22 - v w^T - w v^T
+	  auto alpha = -tau[k] / 2 * np::_blas::dot<Dtype>(m, p.data(), 1, v.data(), 1);
+	  np::_blas::axpy(m, alpha, v.data(), 1, p.data(), 1);
+	  for (np::intp i=0; i<m; i++) {
+	    auto a_i = a22 + i*rs;
+	    np::_blas::axpy(i + 1, -v[i], p.data(), 1, a_i, cs);
+	    np::_blas::axpy(i + 1, -p[i], v.data(), 1, a_i, cs);
+	  }
+	}
+	if (n > 0)
+	  d[n-1] = a[(n-1)*rs + (n-1)*cs];
+      }
+
+      template <class Dtype>
+      void _tridiagonal_ql(np::intp n, Dtype* d, Dtype* e, Dtype* zt=nullptr, np::intp ldz=0, np::intp nz=0) {
+	// Eigenvalues of the symmetric tridiagonal matrix (d, e) by the implicit QL method, into d.
+	// The off-diagonal e is destroyed. If given, the rotations are applied to the rows of zt
+	// (nz elements each, with the stride ldz), so that identity becomes the eigenvectors in its rows.
+	const auto eps = std::numeric_limits<Dtype>::epsilon();
+	if (n > 0)
+	  e[n-1] = Dtype(0);
+	for (np::intp l=0; l<n; l++) {
+	  int iter = 0;
+	  np::intp m;
+	  do {
+	    for (m=l; m<n-1; m++)
+	      if (std::abs(e[m]) <= eps * (std::abs(d[m]) + std::abs(d[m+1])))
+		break;
+	    if (m == l)
+	      break;
+	    if (iter++ == 30)
+	      throw std::runtime_error("LinAlgError: eigh algorithm did not converge");
+	    auto g = (d[l+1] - d[l]) / (2 * e[l]);
+	    auto r = std::hypot(g, Dtype(1));
+	    g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+	    Dtype s = 1, c = 1, p = 0;
+	    np::intp i;
+	    for (i=m-1; i>=l; i--) {
+	      auto f = s * e[i], b = c * e[i];
+	      e[i+1] = (r = std::hypot(f, g));
+	      if (r == Dtype(0)) { // underflow
+		d[i+1] -= p;
+		e[m] = Dtype(0);
+		break;
+	      }
+	      s = f / r;
+	      c = g / r;
+	      g = d[i+1] - p;
+	      r = (d[i] - g) * s + 2 * c * b;
+	      d[i+1] = g + (p = s * r);
+	      g = c * r - b;
+	      if (zt) {
+		auto z_i = zt + i*ldz, z_i1 = zt + (i+1)*ldz;
+		for (np::intp k=0; k<nz; k++) {
+		  f = z_i1[k];
+		  z_i1[k] = s * z_i[k] + c * f;
+		  z_i[k] = c * z_i[k] - s * f;
+		}
+	      }
+	    }
+	    if (r == Dtype(0) and i >= l)
+	      continue;
+	    d[l] -= p;
+	    e[l] = g;
+	    e[m] = Dtype(0);
+	  } while (m != l);
+	}
+      }
+
+      constexpr np::intp dc_small_size = 25;
+
+      template <class Dtype>
+      Dtype _secular_root(np::intp k, const Dtype* delta, const Dtype* z, Dtype rho, Dtype lo, Dtype hi) {
+	// Solves 1 + rho sum(z_j^2 / (delta_j - tau)) = 0 for tau in (lo, hi), where the function
+	// increases monotonically, by Newton's method safeguarded with bisection.
+	const auto eps = std::numeric_limits<Dtype>::epsilon();
+	auto tau = (lo + hi) / 2;
+	for (int iter=0; iter<200; iter++) {
+	  Dtype f = 1, df = 0, bound = 1;
+	  for (np::intp j=0; j<k; j++) {
+	    auto t = z[j] / (delta[j] - tau);
+	    f += rho * z[j] * t;
+	    df += rho * t * t;
+	    bound += std::abs(rho * z[j] * t);
+	  }
+	  if (std::abs(f) <= 4 * k * eps * bound)
+	    break;
+	  if (f > 0)
+	    hi = tau;
+	  else
+	    lo = tau;
+	  auto next = tau - f / df;
+	  if (not (lo < next and next < hi))
+	    next = (lo + hi) / 2;
+	  if (next == tau or hi - lo <= 2 * eps * std::max(std::abs(lo), std::abs(hi)))
+	    break;
+	  tau = next;
+	}
+	return tau;
+      }
+
+      template <class Dtype>
+      void _tridiagonal_dc_merge(np::intp n, np::intp n1, Dtype* d, Dtype* q, np::intp ldq, Dtype rho) {
+	// Given the eigen-decompositions of the two halves in d and the diagonal blocks of q,
+	// solves the rank-one modification D + rho z z^T with z = Q^T (e_{n1-1} + e_{n1}).
+	const auto eps = std::numeric_limits<Dtype>::epsilon();
+	std::vector<Dtype> z(n);
+	for (np::intp j=0; j<n1; j++)
+	  z[j] = q[(n1-1)*ldq + j];
+	for (np::intp j=n1; j<n; j++)
+	  z[j] = q[n1*ldq + j];
+	auto z_norm = np::_blas::nrm2(n, z.data(), 1);
+	np::_blas::scal(n, Dtype(1) / z_norm, z.data(), 1);
+	rho *= z_norm * z_norm;
+
+	// the case rho < 0 is solved for -D - rho z z^T
+	auto sign = rho < 0 ? Dtype(-1) : Dtype(1);
+	rho *= sign;
+	np::_blas::scal(n, sign, d, 1);
+
+	std::vector<np::intp> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [d](np::intp i, np::intp j) { return d[i] < d[j]; });
+	Dtype d_max = 0;
+	for (np::intp j=0; j<n; j++)
+	  d_max = std::max(d_max, std::abs(d[j]));
+	auto tol = 8 * eps * std::max(d_max, rho);
+
+	// deflation: negligible components of z, and close eigenvalues made equal by Givens rotations
+	std::vector<np::intp> idx; // not deflated, in increasing order of d
+	for (auto j : order) {
+	  if (rho * std::abs(z[j]) <= tol)
+	    continue;
+	  if (not idx.empty()) {
+	    auto pj = idx.back();
+	    auto r = std::hypot(z[pj], z[j]);
+	    auto c = z[j] / r, s = -z[pj] / r;
+	    if (std::abs((d[j] - d[pj]) * c * s) <= tol) {
+	      z[j] = r;
+	      z[pj] = Dtype(0);
+	      for (np::intp i=0; i<n; i++) {
+		auto x = q[i*ldq + pj], y = q[i*ldq + j];
+		q[i*ldq + pj] = c * x + s * y;
+		q[i*ldq + j] = c * y - s * x;
+	      }
+	      auto t = d[pj] * c * c + d[j] * s * s;
+	      d[j] = d[pj] * s * s + d[j] * c * c;
+	      d[pj] = t;
+	      idx.pop_back();
+	    }
+	  }
+	  idx.push_back(j);
+	}
+
+	np::intp k = idx.size();
+	if (k > 0) {
+	  std::vector<Dtype> dl(k), zl(k), delta(k), lambda(k);
+	  Dtype z_sq = 0;
+	  for (np::intp i=0; i<k; i++) {
+	    dl[i] = d[idx[i]];
+	    zl[i] = z[idx[i]];
+	    z_sq += zl[i] * zl[i];
+	  }
+
+	  // Each root lies between two consecutive poles (the last one beyond the largest pole);
+	  // it is computed relative to the closer pole so that dl[j] - lambda[i] is accurate.
+	  std::vector<Dtype> diff(k * k); // diff[j*k + i] = dl[j] - lambda[i]
+	  for (np::intp i=0; i<k; i++) {
+	    np::intp origin = i;
+	    Dtype lo = 0, hi = rho * z_sq;
+	    if (i < k - 1) {
+	      auto gap = dl[i+1] - dl[i];
+	      Dtype f = 1;
+	      for (np::intp j=0; j<k; j++)
+		f += rho * zl[j] * zl[j] / ((dl[j] - dl[i]) - gap / 2);
+	      if (f >= 0) {
+		hi = gap / 2;
+	      } else {
+		origin = i + 1;
+		lo = -gap / 2;
+		hi = 0;
+	      }
+	    }
+	    for (np::intp j=0; j<k; j++)
+	      delta[j] = dl[j] - dl[origin];
+	    auto tau = _secular_root(k, delta.data(), zl.data(), rho, lo, hi);
+	    lambda[i] = dl[origin] + tau;
+	    for (np::intp j=0; j<k; j++)
+	      diff[j*k + i] = delta[j] - tau;
+	  }
+
+	  // z recomputed from the roots (Gu & Eisenstat), which keeps the eigenvectors orthogonal
+	  for (np::intp j=0; j<k; j++) {
+	    auto w = diff[j*k + j];
+	    for (np::intp i=0; i<k; i++)
+	      if (i != j)
+		w *= diff[j*k + i] / (dl[j] - dl[i]);
+	    zl[j] = std::copysign(std::sqrt(std::abs(w)), zl[j]);
+	  }
+	  std::vector<Dtype> v(k * k);
+	  for (np::intp i=0; i<k; i++) {
+	    for (np::intp j=0; j<k; j++)
+	      v[j*k + i] = zl[j] / diff[j*k + i];
+	    np::_blas::scal(k, Dtype(1) / np::_blas::nrm2(k, v.data() + i, k), v.data() + i, k);
+	  }
+
+	  // the eigenvectors: Q(:, idx) <- Q(:, idx) V
+	  std::vector<Dtype> q_idx(n * k), q_new(n * k);
+	  for (np::intp r=0; r<n; r++)
+	    for (np::intp i=0; i<k; i++)
+	      q_idx[r*k + i] = q[r*ldq + idx[i]];
+	  np::_blas::gemm(n, k, k, Dtype(1), q_idx.data(), k, np::intp(1), v.data(), k, np::intp(1),
+			  Dtype(0), q_new.data(), k, np::intp(1));
+	  for (np::intp r=0; r<n; r++)
+	    for (np::intp i=0; i<k; i++)
+	      q[r*ldq + idx[i]] = q_new[r*k + i];
+	  for (np::intp i=0; i<k; i++)
+	    d[idx[i]] = lambda[i];
+	}
+	np::_blas::scal(n, sign, d, 1);
+      }
+
+      template <class Dtype>
+      void _tridiagonal_dc(np::intp n, Dtype* d, Dtype* e, Dtype* q, np::intp ldq) {
+	// Eigen-decomposition of the symmetric tridiagonal matrix (d, e) by Cuppen's divide-and-conquer.
+	// The eigenvalues overwrite d in no particular order and the eigenvectors are stored
+	// in the columns of the n x n matrix q. e is destroyed.
+	if (n <= dc_small_size) {
+	  std::vector<Dtype> zt(n * n, Dtype(0));
+	  for (np::intp i=0; i<n; i++)
+	    zt[i*n + i] = Dtype(1);
+	  _tridiagonal_ql(n, d, e, zt.data(), n, n);
+	  for (np::intp i=0; i<n; i++)
+	    for (np::intp j=0; j<n; j++)
+	      q[i*ldq + j] = zt[j*n + i];
+	  return;
+	}
+
+	// T = diag(T1, T2) + rho u u^T with u = e_{n1-1} + e_{n1}
+	auto n1 = n / 2;
+	auto rho = e[n1-1];
+	d[n1-1] -= rho;
+	d[n1] -= rho;
+	for (np::intp i=0; i<n; i++)
+	  for (np::intp j=0; j<n; j++)
+	    if ((i < n1) != (j < n1))
+	      q[i*ldq + j] = Dtype(0);
+	_tridiagonal_dc(n1, d, e, q, ldq);
+	_tridiagonal_dc(n - n1, d + n1, e + n1, q + n1*ldq + n1, ldq);
+	_tridiagonal_dc_merge(n, n1, d, q, ldq, rho);
+      }
+
+      template <class Dtype>
+      np::intp _sturm_count(np::intp n, const Dtype* d, const Dtype* e, Dtype x, Dtype pivmin) {
+	// the number of the eigenvalues less than x
+	np::intp count = 0;
+	Dtype q = 1;
+	for (np::intp i=0; i<n; i++) {
+	  q = d[i] - x - (i > 0 ? e[i-1] * e[i-1] / q : Dtype(0));
+	  if (std::abs(q) < pivmin)
+	    q = -pivmin;
+	  if (q < 0)
+	    count++;
+	}
+	return count;
+      }
+
+      template <class Dtype>
+      void _tridiagonal_bisect(np::intp n, const Dtype* d, const Dtype* e, np::intp il, np::intp iu, Dtype* w) {
+	// The il-th to iu-th smallest eigenvalues of the tridiagonal matrix (d, e), by bisection.
+	const auto eps = std::numeric_limits<Dtype>::epsilon();
+	Dtype gl = d[0], gu = d[0], e_max = 0;
+	for (np::intp i=0; i<n; i++) { // Gershgorin disks
+	  auto r = (i > 0 ? std::abs(e[i-1]) : Dtype(0)) + (i < n-1 ? std::abs(e[i]) : Dtype(0));
+	  gl = std::min(gl, d[i] - r);
+	  gu = std::max(gu, d[i] + r);
+	  if (i < n-1)
+	    e_max = std::max(e_max, e[i] * e[i]);
+	}
+	auto pivmin = std::numeric_limits<Dtype>::min() * std::max(Dtype(1), e_max);
+	auto t_norm = std::max(std::abs(gl), std::abs(gu));
+	gl -= 2 * eps * t_norm * n + pivmin;
+	gu += 2 * eps * t_norm * n + pivmin;
+	for (auto k=il; k<=iu; k++) {
+	  auto lo = k > il ? w[k-il-1] - 2 * eps * t_norm : gl, hi = gu;
+	  while (hi - lo > 2 * eps * std::max(std::abs(lo), std::abs(hi)) + pivmin) {
+	    auto mid = (lo + hi) / 2;
+	    if (mid == lo or mid == hi)
+	      break;
+	    if (_sturm_count(n, d, e, mid, pivmin) > k)
+	      hi = mid;
+	    else
+	      lo = mid;
+	  }
+	  w[k-il] = (lo + hi) / 2;
+	}
+      }
+
+      template <class Dtype>
+      void _tridiagonal_inverse_iteration(np::intp n, const Dtype* d, const Dtype* e, np::intp k, const Dtype* w,
+					  Dtype* z, np::intp rsz, np::intp csz) {
+	// The eigenvectors of the tridiagonal matrix (d, e) for the eigenvalues w (in increasing order)
+	// by inverse iteration with O(n) tridiagonal solves, reorthogonalized within clusters.
+	const auto eps = std::numeric_limits<Dtype>::epsilon();
+	Dtype t_norm = 0;
+	for (np::intp i=0; i<n; i++)
+	  t_norm = std::max(t_norm, std::abs(d[i]) + (i > 0 ? std::abs(e[i-1]) : Dtype(0))
+			    + (i < n-1 ? std::abs(e[i]) : Dtype(0)));
+	t_norm = std::max(t_norm, std::numeric_limits<Dtype>::min());
+	auto cluster_gap = Dtype(1e-3) * t_norm, sep = 10 * eps * t_norm;
+
+	std::vector<Dtype> u0(n), u1(n), u2(n), l(n), x(n);
+	std::vector<bool> swapped(n);
+	np::intp cluster_begin = 0;
+	Dtype shift_prev = 0;
+	std::uint64_t seed = 88172645463325252ull;
+	for (np::intp j=0; j<k; j++) {
+	  auto shift = w[j];
+	  if (j == 0 or w[j] - w[j-1] > cluster_gap)
+	    cluster_begin = j;
+	  else if (shift - shift_prev < sep) // keep the shifts in a cluster apart
+	    shift = shift_prev + sep;
+	  shift_prev = shift;
+
+	  // LU factorization of T - shift I with partial pivoting
+	  auto cur0 = d[0] - shift, cur1 = n > 1 ? e[0] : Dtype(0);
+	  for (np::intp i=0; i<n; i++) {
+	    if (i == n - 1) {
+	      u0[i] = cur0;
+	      break;
+	    }
+	    auto sub = e[i], diag = d[i+1] - shift, sup = i + 1 < n - 1 ? e[i+1] : Dtype(0);
+	    if (std::abs(cur0) >= std::abs(sub)) {
+	      swapped[i] = false;
+	      if (cur0 == Dtype(0))
+		cur0 = eps * t_norm;
+	      l[i] = sub / cur0;
+	      u0[i] = cur0; u1[i] = cur1; u2[i] = Dtype(0);
+	      cur0 = diag - l[i] * cur1;
+	      cur1 = sup;
+	    } else {
+	      swapped[i] = true;
+	      l[i] = cur0 / sub;
+	      u0[i] = sub; u1[i] = diag; u2[i] = sup;
+	      cur0 = cur1 - l[i] * diag;
+	      cur1 = -l[i] * sup;
+	    }
+	  }
+	  for (np::intp i=0; i<n; i++)
+	    if (u0[i] == Dtype(0))
+	      u0[i] = eps * t_norm;
+
+	  // a pseudo-random start
+	  for (np::intp i=0; i<n; i++) {
+	    seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+	    x[i] = Dtype(seed >> 11) / Dtype(1ull << 53) - Dtype(0.5);
+	  }
+	  for (int iter=0; iter<3; iter++) {
+	    for (np::intp i=0; i+1<n; i++) {
+	      if (swapped[i])
+		std::swap(x[i], x[i+1]);
+	      x[i+1] -= l[i] * x[i];
+	    }
+	    for (np::intp i=n-1; i>=0; i--) {
+	      auto s = x[i];
+	      if (i + 1 < n) s -= u1[i] * x[i+1];
+	      if (i + 2 < n) s -= u2[i] * x[i+2];
+	      x[i] = s / u0[i];
+	    }
+	    for (auto c=cluster_begin; c<j; c++) {
+	      auto z_c = z + c*csz;
+	      np::_blas::axpy(n, -np::_blas::dot<Dtype>(n, z_c, rsz, x.data(), 1), z_c, rsz, x.data(), 1);
+	    }
+	    np::_blas::scal(n, Dtype(1) / np::_blas::nrm2(n, x.data(), 1), x.data(), 1);
+	  }
+	  for (np::intp i=0; i<n; i++)
+	    z[i*rsz + j*csz] = x[i];
+	}
+      }
+
+      template <class Dtype>
+      struct Tridiagonal_decomposition {
+
+	matrix<Dtype> t; // the Householder vectors below the first subdiagonal
+	vector<Dtype> d, e, tau;
+	bool lower;
+
+	Tridiagonal_decomposition(const matrix<Dtype>& a, bool lower_=true, bool overwrite_a=false)
+	  : lower(lower_) {
+	  static_assert(std::is_floating_point_v<Dtype>);
+	  if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	    throw std::invalid_argument("ValueError: expected square matrix");
+	  if (overwrite_a)
+	    t = a;
+	  else
+	    t = a.copy();
+	  auto n = t.shape(0);
+	  d = np::zeros<Dtype>({n});
+	  e = np::zeros<Dtype>({std::max<np::intp>(n - 1, 0)});
+	  tau = np::zeros<Dtype>({std::max<np::intp>(n - 1, 0)});
+	  auto [rs, cs] = _strides();
+	  _tridiagonalize(t.data(), rs, cs, n, d.data(), e.data(), tau.data());
+	}
+
+	std::pair<np::intp, np::intp> _strides() const {
+	  // the upper triangle is handled as the lower one of the transpose
+	  auto rs = t.strides()[0], cs = t.strides()[1];
+	  return lower ? std::make_pair(rs, cs) : std::make_pair(cs, rs);
+	}
+
+	void apply_q(Dtype* z, np::intp rsz, np::intp csz, np::intp ncols) const {
+	  // Z <- Q Z for an n x ncols matrix Z
+	  auto n = t.shape(0);
+	  if (n < 2)
+	    return;
+	  auto [rs, cs] = _strides();
+	  _qr::_qr_apply_q(false, t.data() + rs, rs, cs, n - 1, n - 1, tau.data(), z + rsz, rsz, csz, ncols);
+	}
+      };
+
       
       template <class Dtype>
       struct QR {
@@ -107,9 +911,22 @@ namespace scipy {
       	np::float_ eps_eigvals;
 	np::float_ eps_eigvecs;
 	
+	std::vector<Dtype> scale; // balancing
+	std::shared_ptr<Hessenberg_decomposition<Dtype>> hess; // of the balanced matrix, shared by all the eigenvalues
+	
       	QR(const matrix<Dtype>& a_, np::float_ eps_eigvals_=eps_default, np::float_ eps_eigvecs_=eps_default)
       	  : a(a_), eigvecs(np::zeros(a.shape())), eigvals(np::zeros({a.shape(0)})), eps_eigvals(eps_eigvals_), eps_eigvecs(eps_eigvecs_) {}
 
+	void _reduce() {
+	  if (hess)
+	    return;
+	  auto A = a.copy();
+	  auto n = A.shape(0);
+	  scale.resize(n);
+	  _balance(A.data(), A.strides()[0], A.strides()[1], n, scale.data());
+	  hess = std::make_shared<Hessenberg_decomposition<Dtype>>(A, true);
+	}
+
       	bool _converge(const vector<Dtype>& eigvals_new) const {
       	  auto err = norm(eigvals_new - eigvals, 1);
       	  return err < eps_eigvals; 
@@ -124,25 +941,23 @@ namespace scipy {
       	}
 
 	void set_eigvals_with_deflation() {
-	  auto A = a.copy();
-	  
-	  while (A.size())
-	    while (true) {
-	      auto [Q, R] = GramSchmidt(A);
-	      np::matmul(R, Q, A);
-	      auto min_eigval = A(-1, -1);
-	      if (_converge_min(A)) {
-		eigvals(A.shape(0)-1) = min_eigval;
-		A = A(":-1", ":-1");
-		break;
-	      }
-	    }
+	  // Hessenberg reduction followed by the shifted QR algorithm with deflation
+	  _reduce();
+	  auto H = hess->H();
+	  auto n = H.shape(0);
+	  auto w = np::zeros<std::complex<Dtype>>({n});
+	  _hessenberg_qr(H.data(), H.strides()[0], H.strides()[1], n, w.data());
+	  for (np::intp i=0; i<n; i++) {
+	    if (w.data()[i].imag() != 0)
+	      throw std::runtime_error("LinAlgError: complex eigenvalues, use scipy::linalg::eigvals");
+	    eigvals.data()[i] = w.data()[i].real();
+	  }
       	}
 
       	void set_eigvals_without_deflation() {
 	  auto A = a.copy();
       	  while (true) {
-      	    auto [Q, R] = GramSchmidt(A);
+	    auto [Q, R] = qr(A);
       	    np::matmul(R, Q, A);
 	    
 	    auto eigvals_new = np::diag(A);
@@ -159,19 +974,72 @@ namespace scipy {
 	    set_eigvals_without_deflation();
 	}
 
-	void set_eigvecs() {
-	  int i = 0;
-	  for (const auto& eigval : eigvals) {
-	    InverseIteration<Dtype> inv_iter(a, eigval*1.01, eps_eigvecs);
-	    inv_iter.set_eig();
-	    eigvecs(":", i) = inv_iter.eigvec;
-	    ++i;
-	  }
+	bool _is_symmetric() const {
+	  auto n = a.shape(0);
+	  auto rs = a.strides()[0], cs = a.strides()[1];
+	  for (np::intp i=0; i<n; i++)
+	    for (np::intp j=0; j<i; j++)
+	      if (a.data()[i*rs + j*cs] != a.data()[j*rs + i*cs])
+		return false;
+	  return true;
 	}
 
-	void set_eig(bool deflate=true) {
+	void _set_eigvecs_symmetric(int workers) {
+	  // inverse iteration on the tridiagonal form, in parallel over the clusters of eigenvalues
+	  Tridiagonal_decomposition<Dtype> tri(a);
+	  auto n = a.shape(0);
+	  auto d = tri.d.data(), e = tri.e.data();
+	  std::vector<np::intp> order(n);
+	  std::iota(order.begin(), order.end(), 0);
+	  std::sort(order.begin(), order.end(), [this](np::intp i, np::intp j) { return eigvals.data()[i] < eigvals.data()[j]; });
+	  Dtype t_norm = 0;
+	  for (np::intp i=0; i<n; i++)
+	    t_norm = std::max(t_norm, std::abs(d[i]) + (i > 0 ? std::abs(e[i-1]) : Dtype(0)) + (i < n-1 ? std::abs(e[i]) : Dtype(0)));
+	  std::vector<np::intp> clusters{0};
+	  for (np::intp j=1; j<n; j++)
+	    if (eigvals.data()[order[j]] - eigvals.data()[order[j-1]] > Dtype(1e-3) * t_norm)
+	      clusters.push_back(j);
+	  clusters.push_back(n);
+
+	  np::_parallel::parallel_for(clusters.size() - 1, workers, [&](np::intp c) {
+	    auto j0 = clusters[c], k = clusters[c+1] - j0;
+	    std::vector<Dtype> w(k), z(n * k);
+	    for (np::intp j=0; j<k; j++)
+	      w[j] = eigvals.data()[order[j0+j]];
+	    _tridiagonal_inverse_iteration(n, d, e, k, w.data(), z.data(), k, np::intp(1));
+	    auto [rs, cs] = tri._strides();
+	    for (np::intp j=0; j<k; j++) {
+	      _apply_reflectors(tri.t.data(), rs, cs, n, tri.tau.data(), z.data() + j, k);
+	      for (np::intp i=0; i<n; i++)
+		eigvecs.data()[i*n + order[j0+j]] = z[i*k + j];
+	    }
+	  });
+	}
+
+	void set_eigvecs(int workers=-1) {
+	  // Each eigenvector is found by inverse iteration in O(n^2) on the Hessenberg form computed once
+	  // (or the tridiagonal form if `a` is symmetric), for all the eigenvalues concurrently.
+	  // `workers` is the number of threads, -1 meaning all the CPUs; the result does not depend on it.
+	  if (_is_symmetric())
+	    return _set_eigvecs_symmetric(workers);
+	  _reduce();
+	  auto n = a.shape(0);
+	  const auto& h = hess->h;
+	  np::_parallel::parallel_for(n, workers, [&](np::intp i) {
+	    std::vector<Dtype> x(n);
+	    _hessenberg_inverse_iteration(h.data(), h.strides()[0], h.strides()[1], n, eigvals.data()[i], x.data(), eps_eigvecs);
+	    _apply_reflectors(h.data(), h.strides()[0], h.strides()[1], n, hess->tau.data(), x.data(), np::intp(1));
+	    for (np::intp r=0; r<n; r++)
+	      x[r] *= scale[r];
+	    auto x_norm = np::_blas::nrm2(n, x.data(), 1);
+	    for (np::intp r=0; r<n; r++)
+	      eigvecs.data()[r*n + i] = x[r] / x_norm;
+	  });
+	}
+
+	void set_eig(bool deflate=true, int workers=-1) {
 	  set_eigvals(deflate);
-	  set_eigvecs();
+	  set_eigvecs(workers);
 	}
       
       };
@@ -179,6 +1047,545 @@ namespace scipy {
       
       
     }
+
+    template <class Dtype>
+    matrix<Dtype> hessenberg(const matrix<Dtype>& a, bool overwrite_a=false) {
+      return _eigen::Hessenberg_decomposition(a, overwrite_a).H();
+    }
+
+    template <class Dtype>
+    vector<std::complex<Dtype>> eigvals(const matrix<Dtype>& a, bool overwrite_a=false) {
+      // eigenvalues of a general matrix, in no particular order
+      static_assert(std::is_floating_point_v<Dtype>);
+      if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	throw std::invalid_argument("ValueError: expected square matrix");
+      matrix<Dtype> A;
+      if (overwrite_a)
+	A = a;
+      else
+	A = a.copy();
+      return _eigen::_eigvals_general(A);
+    }
+
+    template <class Dtype>
+    std::tuple<vector<Dtype>, matrix<Dtype>> eigh(const matrix<Dtype>& a, bool lower=true, bool eigvals_only=false, bool overwrite_a=false,
+						  std::pair<np::intp, np::intp> subset_by_index={0, -1}) {
+      // Eigenvalues in ascending order and the eigenvectors in the columns of a symmetric matrix,
+      // referencing its `lower` (or upper) triangle only.
+      // subset_by_index : the inclusive range of the indices of the eigenvalues to compute,
+      //                   negative indices counting from the end, e.g. {-k, -1} for the k largest.
+      // If `eigvals_only`, the eigenvectors are returned as an empty array.
+      _eigen::Tridiagonal_decomposition tri(a, lower, overwrite_a);
+      auto n = tri.d.shape(0);
+      auto [il, iu] = subset_by_index;
+      if (il < 0) il += n;
+      if (iu < 0) iu += n;
+      if (n > 0 and (il < 0 or iu >= n or il > iu))
+	throw std::invalid_argument("ValueError: Requested eigenvalue indices are not valid. Valid range is [0, "
+				    + std::to_string(n - 1) + "] and start <= end, but start=" + std::to_string(il)
+				    + ", end=" + std::to_string(iu) + " is given");
+      auto k = n > 0 ? iu - il + 1 : 0;
+      auto d = tri.d.data(), e = tri.e.data();
+
+      auto w = np::empty<Dtype>({k});
+      auto v = np::empty<Dtype>({0});
+      if (k == n and eigvals_only) {
+	// all the eigenvalues by the QL method in O(n^2)
+	std::copy(d, d + n, w.data());
+	std::vector<Dtype> e_(e, e + std::max<np::intp>(n - 1, 0));
+	e_.push_back(Dtype(0));
+	_eigen::_tridiagonal_ql(n, w.data(), e_.data());
+	std::sort(w.data(), w.data() + n);
+      } else if (4 * k > n) {
+	// divide-and-conquer for all the eigenpairs, from which the subset is taken
+	std::vector<Dtype> d_(d, d + n), e_(e, e + std::max<np::intp>(n - 1, 0)), q(n * n);
+	e_.push_back(Dtype(0));
+	_eigen::_tridiagonal_dc(n, d_.data(), e_.data(), q.data(), n);
+	std::vector<np::intp> order(n);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&d_](np::intp i, np::intp j) { return d_[i] < d_[j]; });
+	for (np::intp j=0; j<k; j++)
+	  w.data()[j] = d_[order[il+j]];
+	if (not eigvals_only) {
+	  v = np::empty<Dtype>({n, k});
+	  for (np::intp i=0; i<n; i++)
+	    for (np::intp j=0; j<k; j++)
+	      v.data()[i*k + j] = q[i*n + order[il+j]];
+	}
+      } else {
+	// a few eigenpairs by bisection and inverse iteration
+	_eigen::_tridiagonal_bisect(n, d, e, il, iu, w.data());
+	if (not eigvals_only) {
+	  v = np::empty<Dtype>({n, k});
+	  _eigen::_tridiagonal_inverse_iteration(n, d, e, k, w.data(), v.data(), k, np::intp(1));
+	}
+      }
+      if (not eigvals_only)
+	tri.apply_q(v.data(), k, 1, k);
+      return {w, v};
+    }
+
+    template <class Dtype>
+    vector<Dtype> eigvalsh(const matrix<Dtype>& a, bool lower=true, bool overwrite_a=false,
+			   std::pair<np::intp, np::intp> subset_by_index={0, -1}) {
+      return std::get<0>(eigh(a, lower, true, overwrite_a, subset_by_index));
+    }
+
+
+    namespace _eigen {
+      // implicitly restarted Arnoldi & Lanczos methods for a few eigenpairs
+
+      template <class Dtype>
+      std::vector<std::complex<Dtype>> _dense_eigvec(np::intp m, const Dtype* h, np::intp ld, std::complex<Dtype> theta) {
+	// Unit eigenvector of a small m x m matrix H for its (possibly complex) eigenvalue `theta`,
+	// by inverse iteration on H - theta I factorized with partial pivoting.
+	using C = std::complex<Dtype>;
+	std::vector<C> b(m * m), x(m, C(1));
+	std::vector<np::intp> piv(m);
+	Dtype bnorm = 0;
+	for (np::intp i=0; i<m; i++)
+	  for (np::intp j=0; j<m; j++) {
+	    b[i*m + j] = C(h[i*ld + j]) - (i == j ? theta : C(0));
+	    bnorm = std::max(bnorm, std::abs(b[i*m + j]));
+	  }
+	auto tiny = std::numeric_limits<Dtype>::epsilon() * std::max(bnorm, std::numeric_limits<Dtype>::min());
+	for (np::intp j=0; j<m; j++) {
+	  piv[j] = j + np::_blas::iamax(m - j, b.data() + j*m + j, m);
+	  if (piv[j] != j)
+	    np::_blas::swap(m, b.data() + j*m, 1, b.data() + piv[j]*m, 1);
+	  if (std::abs(b[j*m + j]) < tiny)
+	    b[j*m + j] = tiny;
+	  for (np::intp i=j+1; i<m; i++) {
+	    auto l = b[i*m + j] /= b[j*m + j];
+	    np::_blas::axpy(m - j - 1, -l, b.data() + j*m + j + 1, 1, b.data() + i*m + j + 1, 1);
+	  }
+	}
+	for (int it=0; it<3; it++) {
+	  for (np::intp j=0; j<m; j++)
+	    std::swap(x[j], x[piv[j]]);
+	  np::_blas::trsm(true, true, m, 1, b.data(), m, np::intp(1), x.data(), np::intp(1), np::intp(1));
+	  np::_blas::trsm(false, false, m, 1, b.data(), m, np::intp(1), x.data(), np::intp(1), np::intp(1));
+	  Dtype xnorm = 0;
+	  for (auto& x_i : x)
+	    xnorm += std::norm(x_i);
+	  xnorm = std::sqrt(xnorm);
+	  for (auto& x_i : x)
+	    x_i /= xnorm;
+	}
+	return x;
+      }
+
+      template <class Dtype, bool symmetric>
+      struct Arnoldi {
+	// The implicitly restarted Arnoldi method (Sorensen) for k eigenpairs of an operator of order n
+	// given by `matvec`, as ARPACK does. The factorization A V_m = V_m H_m + beta v_m e_m^T is
+	// extended to length m = ncv, and then compressed back to length k by QR steps on H_m shifted
+	// by its m - k unwanted eigenvalues, until the k wanted Ritz pairs converge.
+	// The basis is kept orthogonal by classical Gram-Schmidt with reorthogonalization (DGKS) and
+	// stored in the rows of V, which is reused over the restarts together with its workspace.
+	// If `symmetric`, this is the implicitly restarted Lanczos method and H_m is tridiagonal.
+	using value_type = std::conditional_t<symmetric, Dtype, std::complex<Dtype>>;
+
+	np::intp n, k, m;
+	matvec_type<Dtype> matvec;
+	std::string which;
+	int maxiter;
+	Dtype tol;
+	std::vector<Dtype> V, V_work; // (m+1) x n
+	std::vector<Dtype> H;         // (m+1) x m
+	std::vector<Dtype> Q, h;      // m x m and m
+	std::vector<value_type> theta; // Ritz values sorted by `which`
+	std::vector<value_type> Y;     // m x k, eigenvectors of H_m for the first k Ritz values
+	Dtype beta = 0;
+	std::uint64_t seed = 0x853c49e6748fea9bULL;
+
+	Arnoldi(np::intp n_, np::intp k_, const matvec_type<Dtype>& matvec_, const std::string& which_="LM",
+		np::intp ncv=0, int maxiter_=0, Dtype tol_=0)
+	  : n(n_), k(k_), matvec(matvec_), which(which_) {
+	  static_assert(std::is_floating_point_v<Dtype>);
+	  auto whiches = symmetric ? std::vector<std::string>{"LM", "SM", "LA", "SA"}
+				   : std::vector<std::string>{"LM", "SM", "LR", "SR", "LI", "SI"};
+	  if (std::find(whiches.begin(), whiches.end(), which) == whiches.end())
+	    throw std::invalid_argument(symmetric ? "ValueError: which must be one of LM SM LA SA"
+					: "ValueError: which must be one of LM SM LR SR LI SI");
+	  auto k_max = symmetric ? n - 1 : n - 2;
+	  if (k <= 0)
+	    throw std::invalid_argument("ValueError: k must be greater than 0.");
+	  if (k > k_max)
+	    throw std::invalid_argument(std::string("ValueError: k must be less than ") + (symmetric ? "ndim(A)" : "ndim(A)-1")
+					+ ", k=" + std::to_string(k));
+	  auto ncv_min = symmetric ? k + 1 : k + 2;
+	  m = ncv > 0 ? ncv : std::min(n, std::max<np::intp>(2*k + 1, 20));
+	  if (m < ncv_min or m > n)
+	    throw std::invalid_argument(std::string("ValueError: ncv must be ") + (symmetric ? "k<ncv<=n" : "k+1<ncv<=n")
+					+ ", ncv=" + std::to_string(m));
+	  maxiter = maxiter_ > 0 ? maxiter_ : 10 * n;
+	  tol = tol_ > 0 ? tol_ : std::numeric_limits<Dtype>::epsilon();
+	  V.resize((m + 1) * n);
+	  V_work.resize((m + 1) * n);
+	  H.resize((m + 1) * m);
+	  Q.resize(m * m);
+	  h.resize(m + 1);
+	  theta.resize(m);
+	  Y.resize(m * k);
+	}
+
+	void _random(Dtype* x) {
+	  // uniform in [-1, 1) by splitmix64, so that the results are reproducible
+	  for (np::intp i=0; i<n; i++) {
+	    auto z = (seed += 0x9e3779b97f4a7c15ULL);
+	    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	    z ^= z >> 31;
+	    x[i] = Dtype(2) * Dtype(z >> 11) / Dtype(1ULL << 53) - Dtype(1);
+	  }
+	}
+
+	Dtype _orthogonalize(np::intp j) {
+	  // Orthogonalizes V(j) against V(:j) twice, leaving the coefficients in h. Returns its norm.
+	  auto w = V.data() + j*n;
+	  std::fill(h.begin(), h.begin() + j, Dtype(0));
+	  for (int pass=0; pass<2; pass++)
+	    for (np::intp i=0; i<j; i++) {
+	      auto c = np::_blas::dot<Dtype>(n, V.data() + i*n, 1, w, 1);
+	      np::_blas::axpy(n, -c, V.data() + i*n, 1, w, 1);
+	      h[i] += c;
+	    }
+	  return np::_blas::nrm2(n, w, 1);
+	}
+
+	bool _normalize(np::intp j, Dtype norm_before) {
+	  // Normalizes V(j) after the orthogonalization, replacing it by a random vector orthogonal
+	  // to V(:j) if it vanished (the basis spans an invariant subspace). Returns false then.
+	  auto w = V.data() + j*n;
+	  auto norm_j = np::_blas::nrm2(n, w, 1);
+	  auto invariant = norm_j <= n * std::numeric_limits<Dtype>::epsilon() * norm_before;
+	  if (invariant) {
+	    if (j >= n) {
+	      std::fill(w, w + n, Dtype(0));
+	      return false;
+	    }
+	    _random(w);
+	    _orthogonalize(j);
+	    norm_j = np::_blas::nrm2(n, w, 1);
+	  }
+	  np::_blas::scal(n, Dtype(1) / norm_j, w, 1);
+	  return not invariant;
+	}
+
+	void _extend(np::intp j0) {
+	  // extends the factorization from length j0 to m
+	  for (np::intp j=j0; j<m; j++) {
+	    auto w = V.data() + (j + 1)*n;
+	    matvec(V.data() + j*n, w);
+	    auto norm_w = np::_blas::nrm2(n, w, 1);
+	    auto norm_r = _orthogonalize(j + 1);
+	    for (np::intp i=0; i<=j; i++)
+	      H[i*m + j] = h[i];
+	    for (np::intp i=j+2; i<=m; i++)
+	      H[i*m + j] = Dtype(0);
+	    H[(j + 1)*m + j] = _normalize(j + 1, norm_w) ? norm_r : Dtype(0);
+	  }
+	  beta = H[m*m + m - 1];
+	}
+
+	Dtype _key(const value_type& t) const {
+	  // wanted Ritz values first
+	  if (which == "LM") return -std::abs(t);
+	  if (which == "SM") return std::abs(t);
+	  if (which == "LA" or which == "LR") return -std::real(t);
+	  if (which == "SA" or which == "SR") return std::real(t);
+	  if (which == "LI") return -std::abs(std::imag(t));
+	  return std::abs(std::imag(t));
+	}
+
+	void _ritz() {
+	  // Ritz values of H_m sorted by `which`, and the eigenvectors of H_m for the first k of them
+	  std::vector<np::intp> order(m);
+	  std::iota(order.begin(), order.end(), 0);
+	  if constexpr (symmetric) {
+	    // H_m is tridiagonal: the QL method gets the small last components of its eigenvectors,
+	    // and so the residual norms, to high relative accuracy
+	    std::vector<Dtype> d(m), e(m), zt(m * m, Dtype(0));
+	    for (np::intp i=0; i<m; i++) {
+	      d[i] = H[i*m + i];
+	      e[i] = i < m - 1 ? H[(i + 1)*m + i] : Dtype(0);
+	      zt[i*m + i] = Dtype(1);
+	    }
+	    _tridiagonal_ql(m, d.data(), e.data(), zt.data(), m, m);
+	    std::stable_sort(order.begin(), order.end(), [&](np::intp i, np::intp j) { return _key(d[i]) < _key(d[j]); });
+	    for (np::intp c=0; c<m; c++)
+	      theta[c] = d[order[c]];
+	    for (np::intp i=0; i<m; i++)
+	      for (np::intp c=0; c<k; c++)
+		Y[i*k + c] = zt[order[c]*m + i];
+	  } else {
+	    std::vector<Dtype> Hm(H.begin(), H.begin() + m*m);
+	    std::vector<value_type> w(m);
+	    _hessenberg_qr(Hm.data(), m, np::intp(1), m, w.data());
+	    std::stable_sort(order.begin(), order.end(), [&](np::intp i, np::intp j) { return _key(w[i]) < _key(w[j]); });
+	    for (np::intp c=0; c<m; c++)
+	      theta[c] = w[order[c]];
+	    for (np::intp c=0; c<k; c++) {
+	      auto y = _dense_eigvec(m, H.data(), m, theta[c]);
+	      for (np::intp i=0; i<m; i++)
+		Y[i*k + c] = y[i];
+	    }
+	  }
+	}
+
+	np::intp _converged() const {
+	  // number of the first k Ritz pairs with residual norm |beta y(m-1)| <= tol |theta|, as in ARPACK
+	  const auto eps23 = std::pow(std::numeric_limits<Dtype>::epsilon(), Dtype(2) / 3);
+	  np::intp nconv = 0;
+	  for (np::intp c=0; c<k; c++)
+	    if (std::abs(beta * Y[(m - 1)*k + c]) <= tol * std::max(eps23, std::abs(theta[c])))
+	      nconv++;
+	  return nconv;
+	}
+
+	void _shifted_qr_step(np::intp lo, np::intp hi, bool double_shift, Dtype s, Dtype t) {
+	  // One implicit QR step on the unreduced block H(lo:hi+1, lo:hi+1) with the shift s, or with
+	  // the roots of x^2 - s x + t if `double_shift`, chasing the bulge by reflectors of order 2
+	  // or 3. The transform is applied to the whole of H and accumulated into Q in O(m^2).
+	  auto h = [this](np::intp i, np::intp j) -> Dtype& { return H[i*m + j]; };
+	  Dtype v[3];
+	  for (np::intp k0=lo; k0<hi; k0++) {
+	    auto nr = std::min<np::intp>(double_shift ? 3 : 2, hi - k0 + 1);
+	    if (k0 > lo)
+	      for (np::intp i=0; i<nr; i++)
+		v[i] = h(k0 + i, k0 - 1);
+	    else if (double_shift) {
+	      // the first column of H^2 - s H + t I
+	      v[0] = h(lo, lo)*h(lo, lo) + h(lo, lo + 1)*h(lo + 1, lo) - s*h(lo, lo) + t;
+	      v[1] = h(lo + 1, lo)*(h(lo, lo) + h(lo + 1, lo + 1) - s);
+	      v[2] = nr == 3 ? h(lo + 1, lo)*h(lo + 2, lo + 1) : Dtype(0);
+	    } else {
+	      v[0] = h(lo, lo) - s;
+	      v[1] = h(lo + 1, lo);
+	    }
+	    auto tau = _qr::_householder(nr, v, np::intp(1));
+	    if (k0 > lo) {
+	      h(k0, k0 - 1) = v[0];
+	      for (np::intp i=1; i<nr; i++)
+		h(k0 + i, k0 - 1) = Dtype(0);
+	    }
+	    if (tau == Dtype(0))
+	      continue;
+	    v[0] = Dtype(1);
+	    // H <- P H <- H P and Q <- Q P for P = I - tau v v^T acting on k0:k0+nr
+	    for (np::intp j=k0; j<m; j++) {
+	      auto d = tau * np::_blas::dot<Dtype>(nr, v, 1, &h(k0, j), m);
+	      np::_blas::axpy(nr, -d, v, 1, &h(k0, j), m);
+	    }
+	    for (np::intp i=0; i<=std::min(k0 + nr, hi); i++) {
+	      auto d = tau * np::_blas::dot<Dtype>(nr, v, 1, &h(i, k0), 1);
+	      np::_blas::axpy(nr, -d, v, 1, &h(i, k0), 1);
+	    }
+	    for (np::intp i=0; i<m; i++) {
+	      auto q_i = Q.data() + i*m + k0;
+	      auto d = tau * np::_blas::dot<Dtype>(nr, v, 1, q_i, 1);
+	      np::_blas::axpy(nr, -d, v, 1, q_i, 1);
+	    }
+	  }
+	}
+
+	void _restart(np::intp kk) {
+	  // Applies the Ritz values theta(kk:) as exact shifts, H_m <- Q^T H_m Q and V_m <- V_m Q,
+	  // complex conjugate pairs at once in real arithmetic, and truncates to length kk.
+	  const auto eps = std::numeric_limits<Dtype>::epsilon();
+	  std::fill(Q.begin(), Q.end(), Dtype(0));
+	  for (np::intp i=0; i<m; i++)
+	    Q[i*m + i] = Dtype(1);
+	  for (np::intp s=kk; s<m; s++) {
+	    auto mu = theta[s];
+	    auto double_shift = std::imag(mu) != 0;
+	    if (std::imag(mu) < 0 or (double_shift and std::find(theta.begin() + kk, theta.end(), std::conj(mu)) == theta.end()))
+	      continue; // applied with its conjugate
+	    // each unreduced block is shifted independently
+	    np::intp lo = 0;
+	    for (np::intp i=0; i<m; i++) {
+	      if (i < m - 1 and std::abs(H[(i + 1)*m + i]) > eps * (std::abs(H[i*m + i]) + std::abs(H[(i + 1)*m + i + 1])))
+		continue;
+	      if (i < m - 1)
+		H[(i + 1)*m + i] = Dtype(0);
+	      if (i > lo)
+		_shifted_qr_step(lo, i, double_shift, double_shift ? 2 * std::real(mu) : std::real(mu), std::norm(mu));
+	      lo = i + 1;
+	    }
+	  }
+	  for (np::intp i=2; i<m; i++)
+	    std::fill(H.begin() + i*m, H.begin() + i*m + i - 1, Dtype(0));
+
+	  // V(:kk+1) <- Q(:, :kk+1)^T V(:m), and the new residual
+	  //   f = V(kk) H(kk, kk-1) + beta v_m Q(m-1, kk-1)
+	  np::_blas::gemm(kk + 1, n, m, Dtype(1), Q.data(), np::intp(1), m, V.data(), n, np::intp(1),
+			  Dtype(0), V_work.data(), n, np::intp(1));
+	  auto f = V_work.data() + kk*n;
+	  np::_blas::scal(n, H[kk*m + kk - 1], f, 1);
+	  np::_blas::axpy(n, beta * Q[(m - 1)*m + kk - 1], V.data() + m*n, 1, f, 1);
+	  std::swap(V, V_work);
+	  auto norm_f = np::_blas::nrm2(n, f = V.data() + kk*n, 1);
+	  for (np::intp i=kk; i<=m; i++)
+	    std::fill(H.begin() + i*m, H.begin() + (i + 1)*m, Dtype(0));
+	  for (np::intp i=0; i<kk; i++)
+	    std::fill(H.begin() + i*m + kk, H.begin() + (i + 1)*m, Dtype(0));
+	  auto norm_before = norm_f;
+	  norm_f = _orthogonalize(kk);
+	  H[kk*m + kk - 1] = _normalize(kk, norm_before) ? norm_f : Dtype(0);
+	}
+
+	void run() {
+	  _random(V.data());
+	  np::_blas::scal(n, Dtype(1) / np::_blas::nrm2(n, V.data(), 1), V.data(), 1);
+	  _extend(0);
+	  for (int iter=0; ; iter++) {
+	    _ritz();
+	    auto nconv = _converged();
+	    if (nconv >= k or beta == Dtype(0))
+	      return;
+	    if (iter >= maxiter)
+	      throw std::runtime_error("ArpackNoConvergence: No convergence (" + std::to_string(maxiter) + " iterations, "
+				       + std::to_string(nconv) + "/" + std::to_string(k) + " eigenvectors converged)");
+	    // keep some converged pairs beyond k to speed up, without splitting a conjugate pair
+	    auto kk = k + std::min(nconv, (m - k) / 2);
+	    if constexpr (not symmetric)
+	      if (std::imag(theta[kk - 1]) != 0 and theta[kk] == std::conj(theta[kk - 1]))
+		kk += kk + 1 < m ? 1 : -1;
+	    _restart(kk);
+	    _extend(kk);
+	  }
+	}
+
+	matrix<value_type> eigenvectors() const {
+	  // Ritz vectors V_m^T Y in the columns
+	  auto X = np::empty<value_type>({n, k});
+	  np::_blas::gemm(n, k, m, value_type(1), V.data(), np::intp(1), n, Y.data(), k, np::intp(1),
+			  value_type(0), X.data(), k, np::intp(1));
+	  return X;
+	}
+      };
+
+      template <class Dtype>
+      matvec_type<Dtype> _shift_invert(const _solve::LU_decomposition<Dtype>& lu) {
+	// y = inv(A - sigma I) x given the LU factorization of A - sigma I
+	return [lu](const Dtype* x, Dtype* y) {
+	  auto n = lu.LU.shape(0);
+	  auto rs = lu.LU.strides()[0], cs = lu.LU.strides()[1];
+	  auto p = lu.p.data();
+	  auto ps = lu.p.strides()[0];
+	  for (np::intp i=0; i<n; i++)
+	    y[i] = x[p[i*ps]];
+	  np::_blas::trsm(true, true, n, 1, lu.LU.data(), rs, cs, y, np::intp(1), np::intp(1));
+	  np::_blas::trsm(false, false, n, 1, lu.LU.data(), rs, cs, y, np::intp(1), np::intp(1));
+	};
+      }
+
+      template <bool symmetric, class Dtype>
+      auto _arpack(np::intp n, const matvec_type<Dtype>& matvec, np::intp k, const std::string& which,
+		   np::intp ncv, int maxiter, Dtype tol, bool return_eigenvectors, Dtype sigma) {
+	// Runs the Arnoldi method and maps the Ritz values nu of inv(A - sigma I) back to
+	// sigma + 1/nu unless sigma is NaN. Eigenvalues of a symmetric operator are sorted ascending.
+	using value_type = typename Arnoldi<Dtype, symmetric>::value_type;
+	Arnoldi<Dtype, symmetric> arnoldi(n, k, matvec, which, ncv, maxiter, tol);
+	arnoldi.run();
+	std::vector<np::intp> order(k);
+	std::iota(order.begin(), order.end(), 0);
+	std::vector<value_type> lambda(arnoldi.theta.begin(), arnoldi.theta.begin() + k);
+	if (not std::isnan(sigma))
+	  for (auto& l : lambda)
+	    l = sigma + value_type(1) / l;
+	if constexpr (symmetric)
+	  std::stable_sort(order.begin(), order.end(), [&](np::intp i, np::intp j) { return lambda[i] < lambda[j]; });
+	auto w = np::empty<value_type>({k});
+	for (np::intp c=0; c<k; c++)
+	  w.data()[c] = lambda[order[c]];
+	auto v = np::empty<value_type>({0});
+	if (return_eigenvectors) {
+	  auto X = arnoldi.eigenvectors();
+	  v = np::empty<value_type>({n, k});
+	  for (np::intp i=0; i<n; i++)
+	    for (np::intp c=0; c<k; c++)
+	      v.data()[i*k + c] = X.data()[i*k + order[c]];
+	}
+	return std::tuple<vector<value_type>, matrix<value_type>>{w, v};
+      }
+
+      template <class Dtype>
+      matvec_type<Dtype> _dense_matvec(const matrix<Dtype>& a) {
+	return [a](const Dtype* x, Dtype* y) {
+	  np::_blas::gemv(a.shape(0), a.shape(1), Dtype(1), a.data(), a.strides()[0], a.strides()[1],
+			  x, np::intp(1), Dtype(0), y, np::intp(1));
+	};
+      }
+
+    }
+
+    template <class Dtype>
+    std::tuple<vector<Dtype>, matrix<Dtype>> eigsh(np::intp n, const matvec_type<Dtype>& matvec, np::intp k=6, const std::string& which="LM",
+						   np::intp ncv=0, int maxiter=0, Dtype tol=0, bool return_eigenvectors=true) {
+      // k eigenpairs of a symmetric operator of order n given by `matvec`, by the implicitly
+      // restarted Lanczos method. The eigenvalues are sorted ascending and the eigenvectors are
+      // in the columns.
+      // which : "LM" / "SM" for the largest / smallest magnitude, "LA" / "SA" for the largest / smallest values
+      // ncv : the length of the Lanczos basis, k < ncv <= n (default: min(n, max(2k+1, 20)))
+      // maxiter : the number of restarts (default: 10n), tol : relative accuracy (default: machine precision)
+      return _eigen::_arpack<true>(n, matvec, k, which, ncv, maxiter, tol, return_eigenvectors,
+				   std::numeric_limits<Dtype>::quiet_NaN());
+    }
+
+    template <class Dtype>
+    std::tuple<vector<Dtype>, matrix<Dtype>> eigsh(const _solve::LU_decomposition<Dtype>& lu, Dtype sigma, np::intp k=6, const std::string& which="LM",
+						   np::intp ncv=0, int maxiter=0, Dtype tol=0, bool return_eigenvectors=true) {
+      // shift-invert mode given the LU factorization of A - sigma I: `which` then applies to
+      // 1 / (lambda - sigma), so that "LM" gives the eigenvalues nearest to sigma
+      return _eigen::_arpack<true>(lu.LU.shape(0), _eigen::_shift_invert(lu), k, which, ncv, maxiter, tol,
+				   return_eigenvectors, sigma);
+    }
+
+    template <class Dtype>
+    std::tuple<vector<Dtype>, matrix<Dtype>> eigsh(const matrix<Dtype>& a, np::intp k=6, Dtype sigma=std::numeric_limits<Dtype>::quiet_NaN(),
+						   const std::string& which="LM", np::intp ncv=0, int maxiter=0, Dtype tol=0,
+						   bool return_eigenvectors=true) {
+      // sigma : NaN (default) for none, or the shift for the shift-invert mode
+      if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	throw std::invalid_argument("ValueError: expected square matrix");
+      if (std::isnan(sigma))
+	return eigsh(a.shape(0), _eigen::_dense_matvec(a), k, which, ncv, maxiter, tol, return_eigenvectors);
+      return eigsh(_solve::LU_decomposition<Dtype>(a - sigma * np::identity(a.shape(0))), sigma, k, which, ncv, maxiter, tol,
+		   return_eigenvectors);
+    }
+
+    template <class Dtype>
+    std::tuple<vector<std::complex<Dtype>>, matrix<std::complex<Dtype>>> eigs(np::intp n, const matvec_type<Dtype>& matvec, np::intp k=6, const std::string& which="LM",
+									      np::intp ncv=0, int maxiter=0, Dtype tol=0, bool return_eigenvectors=true) {
+      // k eigenpairs of a general operator of order n given by `matvec`, by the implicitly
+      // restarted Arnoldi method, in the order given by `which`.
+      // which : "LM" / "SM" for the largest / smallest magnitude, "LR" / "SR" for the largest / smallest
+      //         real part, "LI" / "SI" for the largest / smallest imaginary part
+      // ncv : the length of the Arnoldi basis, k + 1 < ncv <= n (default: min(n, max(2k+1, 20)))
+      return _eigen::_arpack<false>(n, matvec, k, which, ncv, maxiter, tol, return_eigenvectors,
+				    std::numeric_limits<Dtype>::quiet_NaN());
+    }
+
+    template <class Dtype>
+    std::tuple<vector<std::complex<Dtype>>, matrix<std::complex<Dtype>>> eigs(const _solve::LU_decomposition<Dtype>& lu, Dtype sigma, np::intp k=6, const std::string& which="LM",
+									      np::intp ncv=0, int maxiter=0, Dtype tol=0, bool return_eigenvectors=true) {
+      return _eigen::_arpack<false>(lu.LU.shape(0), _eigen::_shift_invert(lu), k, which, ncv, maxiter, tol,
+				    return_eigenvectors, sigma);
+    }
+
+    template <class Dtype>
+    std::tuple<vector<std::complex<Dtype>>, matrix<std::complex<Dtype>>> eigs(const matrix<Dtype>& a, np::intp k=6, Dtype sigma=std::numeric_limits<Dtype>::quiet_NaN(),
+									      const std::string& which="LM", np::intp ncv=0, int maxiter=0, Dtype tol=0,
+									      bool return_eigenvectors=true) {
+      if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	throw std::invalid_argument("ValueError: expected square matrix");
+      if (std::isnan(sigma))
+	return eigs(a.shape(0), _eigen::_dense_matvec(a), k, which, ncv, maxiter, tol, return_eigenvectors);
+      return eigs(_solve::LU_decomposition<Dtype>(a - sigma * np::identity(a.shape(0))), sigma, k, which, ncv, maxiter, tol,
+		  return_eigenvectors);
+    }
     
   }
   
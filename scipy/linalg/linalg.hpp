@@ -1,5 +1,7 @@
 #pragma once
 
+#include <scipy/sparse/sparse.hpp>
 #include <scipy/linalg/core.hpp>
+#include <scipy/linalg/qr.hpp>
 #include <scipy/linalg/solve.hpp>
 #include <scipy/linalg/eigen.hpp>
@@ -0,0 +1,186 @@
+#pragma once
+
+namespace scipy {
+
+  namespace linalg {
+
+    namespace _qr {
+
+      // Householder QR decomposition.
+      // A is overwritten by R on and above the diagonal and by the Householder vectors below it,
+      // as LAPACK's geqrf does. Blocks of reflectors are applied at once in the compact WY form
+      //   H_1 H_2 ... H_k = I - V T V^T
+      // so that most of the work is done by GEMM.
+
+      constexpr np::intp qr_block_size = 32;
+
+      template <class Dtype>
+      Dtype _householder(np::intp n, Dtype* x, np::intp incx) {
+	// Generates H = I - tau v v^T with v(0) = 1 such that H x = (beta, 0, ..., 0)^T.
+	// x(0) is overwritten by beta and x(1:) by v(1:). Returns tau.
+	if (n <= 1)
+	  return Dtype(0);
+	auto xnorm = np::_blas::nrm2(n - 1, x + incx, incx);
+	if (xnorm == Dtype(0))
+	  return Dtype(0);
+	auto alpha = x[0];
+	auto beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+	np::_blas::scal(n - 1, Dtype(1) / (alpha - beta), x + incx, incx);
+	x[0] = beta;
+	return (beta - alpha) / beta;
+      }
+
+      template <class Dtype>
+      void _qr_factor_panel(Dtype* a, np::intp rs, np::intp cs, np::intp m, np::intp n, Dtype* tau, Dtype* work) {
+	// Unblocked Householder QR of an m x n panel; `work` holds n elements.
+	auto k = std::min(m, n);
+	for (np::intp j=0; j<k; j++) {
+	  auto a_j = a + j*rs + j*cs;
+	  tau[j] = _householder(m - j, a_j, rs);
+	  if (tau[j] == Dtype(0) or j == n - 1)
+	    continue;
+	  // A(j:, j+1:) <- H A(j:, j+1:) row by row: w = A^T v, A -= tau v w^T
+	  auto nc = n - j - 1;
+	  auto beta = a_j[0];
+	  a_j[0] = Dtype(1);
+	  std::fill(work, work + nc, Dtype(0));
+	  for (np::intp i=0; i<m-j; i++)
+	    np::_blas::axpy(nc, a_j[i*rs], a_j + i*rs + cs, cs, work, 1);
+	  for (np::intp i=0; i<m-j; i++)
+	    np::_blas::axpy(nc, -tau[j] * a_j[i*rs], work, 1, a_j + i*rs + cs, cs);
+	  a_j[0] = beta;
+	}
+      }
+
+      template <class Dtype>
+      struct _block_reflector {
+	// I - V T V^T for the reflectors stored in the columns of an m x k panel
+	np::intp m, k;
+	std::vector<Dtype> V; // m x k, unit lower trapezoidal
+	std::vector<Dtype> T; // k x k, upper triangular
+
+	_block_reflector(const Dtype* a, np::intp rs, np::intp cs, np::intp m_, np::intp k_, const Dtype* tau)
+	  : m(m_), k(k_), V(m_ * k_), T(k_ * k_) {
+	  for (np::intp r=0; r<m; r++)
+	    for (np::intp c=0; c<k; c++)
+	      V[r*k + c] = r < c ? Dtype(0) : r == c ? Dtype(1) : a[r*rs + c*cs];
+
+	  // T(:i, i) = -tau_i T(:i, :i) V(:, :i)^T v_i  (LAPACK's larft)
+	  std::vector<Dtype> z(k);
+	  for (np::intp i=0; i<k; i++) {
+	    T[i*k + i] = tau[i];
+	    np::_blas::gemv(i, m - i, Dtype(1), V.data() + i*k, 1, k, V.data() + i*k + i, k,
+			    Dtype(0), z.data(), 1);
+	    for (np::intp r=0; r<i; r++)
+	      T[r*k + i] = -tau[i] * np::_blas::dot<Dtype>(i - r, T.data() + r*k + r, 1, z.data() + r, 1);
+	  }
+	}
+
+	void apply(bool trans, Dtype* c, np::intp rsc, np::intp csc, np::intp n) const {
+	  // C <- H C (or H^T C if `trans`) for an m x n matrix C
+	  if (n == 0 or k == 0)
+	    return;
+	  std::vector<Dtype> W(k * n), TW(k * n);
+	  // W = V^T C
+	  np::_blas::gemm(k, n, m, Dtype(1), V.data(), 1, k, c, rsc, csc, Dtype(0), W.data(), n, 1);
+	  // TW = T W or T^T W
+	  if (trans)
+	    np::_blas::gemm(k, n, k, Dtype(1), T.data(), 1, k, W.data(), n, 1, Dtype(0), TW.data(), n, 1);
+	  else
+	    np::_blas::gemm(k, n, k, Dtype(1), T.data(), k, 1, W.data(), n, 1, Dtype(0), TW.data(), n, 1);
+	  // C -= V TW
+	  np::_blas::gemm(m, n, k, Dtype(-1), V.data(), k, 1, TW.data(), n, 1, Dtype(1), c, rsc, csc);
+	}
+      };
+
+      template <class Dtype>
+      void _qr_factor_blocked(Dtype* a, np::intp rs, np::intp cs, np::intp m, np::intp n, Dtype* tau) {
+	auto k = std::min(m, n);
+	std::vector<Dtype> work(n);
+	for (np::intp j0=0; j0<k; j0+=qr_block_size) {
+	  auto jb = std::min(qr_block_size, k - j0);
+	  auto a_j = a + j0*rs + j0*cs;
+	  _qr_factor_panel(a_j, rs, cs, m - j0, jb, tau + j0, work.data());
+	  if (j0 + jb < n)
+	    _block_reflector(a_j, rs, cs, m - j0, jb, tau + j0).apply(true, a_j + jb*cs, rs, cs, n - j0 - jb);
+	}
+      }
+
+      template <class Dtype>
+      void _qr_apply_q(bool trans, const Dtype* a, np::intp rs, np::intp cs, np::intp m, np::intp k,
+		       const Dtype* tau, Dtype* c, np::intp rsc, np::intp csc, np::intp n) {
+	// C <- Q C (or Q^T C if `trans`) for Q = H_1 ... H_k given by _qr_factor_blocked
+	auto n_blocks = (k + qr_block_size - 1) / qr_block_size;
+	for (np::intp b=0; b<n_blocks; b++) {
+	  auto j0 = (trans ? b : n_blocks - 1 - b) * qr_block_size;
+	  auto jb = std::min(qr_block_size, k - j0);
+	  _block_reflector(a + j0*rs + j0*cs, rs, cs, m - j0, jb, tau + j0).apply(trans, c + j0*rsc, rsc, csc, n);
+	}
+      }
+
+      template <class Dtype>
+      struct QR_decomposition {
+
+	matrix<Dtype> qr; // R and the Householder vectors
+	vector<Dtype> tau;
+
+	QR_decomposition(const matrix<Dtype>& a, bool overwrite_a=false) {
+	  static_assert(std::is_floating_point_v<Dtype>);
+	  if (a.ndim() != 2)
+	    throw std::invalid_argument("ValueError: expected a 2-D array");
+	  if (overwrite_a)
+	    qr = a;
+	  else
+	    qr = a.copy();
+	  tau = np::zeros<Dtype>({std::min(qr.shape(0), qr.shape(1))});
+	  _qr_factor_blocked(qr.data(), qr.strides()[0], qr.strides()[1], qr.shape(0), qr.shape(1), tau.data());
+	}
+
+	matrix<Dtype> R(bool economic=false) const {
+	  auto m = qr.shape(0), n = qr.shape(1);
+	  auto rows = economic ? std::min(m, n) : m;
+	  auto ret = np::zeros<Dtype>({rows, n});
+	  auto rs = qr.strides()[0], cs = qr.strides()[1];
+	  for (np::intp i=0; i<rows; i++)
+	    for (np::intp j=i; j<n; j++)
+	      ret.data()[i*n + j] = qr.data()[i*rs + j*cs];
+	  return ret;
+	}
+
+	matrix<Dtype> Q(bool economic=false) const {
+	  auto m = qr.shape(0), k = tau.shape(0);
+	  auto cols = economic ? k : m;
+	  auto ret = np::zeros<Dtype>({m, cols});
+	  for (np::intp i=0; i<cols; i++)
+	    ret.data()[i*cols + i] = Dtype(1);
+	  apply_q(ret, false);
+	  return ret;
+	}
+
+	void apply_q(matrix<Dtype>& c, bool trans) const {
+	  // c <- Q c or Q^T c in-place
+	  auto ncols = c.ndim() == 1 ? 1 : c.shape(1);
+	  auto csc = c.ndim() == 1 ? 1 : c.strides()[1];
+	  _qr_apply_q(trans, qr.data(), qr.strides()[0], qr.strides()[1], qr.shape(0), tau.shape(0), tau.data(),
+		      c.data(), c.strides()[0], csc, ncols);
+	}
+      };
+
+    }
+
+    template <class Dtype>
+    std::tuple<matrix<Dtype>, matrix<Dtype>> qr(const matrix<Dtype>& a, bool overwrite_a=false, const std::string& mode="full") {
+      // mode : "full" for Q (M, M) and R (M, N), "economic" for Q (M, K) and R (K, N) with K = min(M, N),
+      //        "r" for R (M, N) only, in which case Q is returned as an empty array.
+      if (mode != "full" and mode != "economic" and mode != "r")
+	throw std::invalid_argument("ValueError: Mode argument should be one of ['full', 'r', 'economic']");
+      auto QR = _qr::QR_decomposition(a, overwrite_a);
+      if (mode == "r")
+	return {np::empty<Dtype>({0}), QR.R()};
+      auto economic = mode == "economic";
+      return {QR.Q(economic), QR.R(economic)};
+    }
+
+  }
+
+}
@@ -8,74 +8,150 @@ namespace scipy {
 
       /* direct solvers */
     
+      constexpr np::intp lu_block_size = 128;
+
       template <class Dtype>
-      void _forward_elimination_step(matrix<Dtype>& a, vector<int>& p) {
-	// pivot selection
-	auto abs_first_col = np::fabs(a(":", 0));
-	auto itr_pivot = std::max_element(abs_first_col.begin(), abs_first_col.end());
-	auto idx_pivot = itr_pivot.get_index();
-
-	// swap
-	if (idx_pivot) {
-	  auto tmp = a(idx_pivot).copy();
-	  a(idx_pivot) = a(0);
-	  a(0) = tmp;
-
-	  auto tmp_p = p[{idx_pivot}];
-	  p(idx_pivot) = p(0);
-	  p(0) = tmp_p;
+      void _lu_factor_panel(Dtype* a, np::intp rs, np::intp cs, np::intp m,
+			    np::intp c0, np::intp cn, np::intp j0, np::intp jb, np::intp* ipiv) {
+	// Factorizes the columns j0, ..., j0+jb-1 (rows j0, ..., m-1) with partial pivoting,
+	// splitting them recursively in halves so that most of the work is done by GEMM.
+	// Row interchanges are recorded in `ipiv` and applied to the columns c0, ..., c0+cn-1 only.
+	if (jb == 1) {
+	  auto a_j = a + j0*rs;
+	  
+	  // pivot selection
+	  auto idx_pivot = j0 + np::_blas::iamax(m - j0, a_j + j0*cs, rs);
+	  ipiv[j0] = idx_pivot;
+
+	  // swap
+	  if (idx_pivot != j0)
+	    np::_blas::swap(cn, a_j + c0*cs, cs, a + idx_pivot*rs + c0*cs, cs);
+
+	  auto pivot = a_j[j0*cs];
+	  if (pivot != Dtype(0)) // otherwise singular
+	    np::_blas::scal(m - j0 - 1, Dtype(1) / pivot, a_j + rs + j0*cs, rs);
+	  return;
 	}
-      
-	// sweap
-	auto sl = slice("1:");
-	a(sl, 0) *= 1.0 / *a.begin();
-	a(sl, sl) -= a(0, sl) * a(sl, slice(0, 1));
+	
+	auto n1 = jb / 2;
+	auto j1 = j0 + n1;
+	_lu_factor_panel(a, rs, cs, m, c0, cn, j0, n1, ipiv);
+	// A12 <- inv(L11) A12
+	np::_blas::trsm(true, true, n1, jb - n1, a + j0*rs + j0*cs, rs, cs, a + j0*rs + j1*cs, rs, cs);
+	// A22 <- A22 - L21 A12
+	np::_blas::gemm(m - j1, jb - n1, n1, Dtype(-1), a + j1*rs + j0*cs, rs, cs, a + j0*rs + j1*cs, rs, cs,
+			Dtype(1), a + j1*rs + j1*cs, rs, cs);
+	_lu_factor_panel(a, rs, cs, m, c0, cn, j1, jb - n1, ipiv);
+      }
+
+      template <class Dtype>
+      void _lu_swap_rows(Dtype* a, np::intp rs, np::intp cs, np::intp c0, np::intp cn,
+			 np::intp i0, np::intp i1, const np::intp* ipiv) {
+	// applies the row interchanges ipiv[i0], ..., ipiv[i1-1] to the columns c0, ..., c0+cn-1
+	for (np::intp i=i0; i<i1; i++)
+	  if (ipiv[i] != i)
+	    np::_blas::swap(cn, a + i*rs + c0*cs, cs, a + ipiv[i]*rs + c0*cs, cs);
+      }
+
+      template <class Dtype>
+      void _lu_update_block_column(Dtype* a, np::intp rs, np::intp cs, np::intp m,
+				   np::intp c0, np::intp cn, np::intp j0, np::intp jb, const np::intp* ipiv) {
+	// Brings the columns c0, ..., c0+cn-1 up to date with the block step j0, ..., j0+jb-1.
+	_lu_swap_rows(a, rs, cs, c0, cn, j0, j0 + jb, ipiv);
+	// A12 <- inv(L11) A12
+	np::_blas::trsm(true, true, jb, cn, a + j0*rs + j0*cs, rs, cs, a + j0*rs + c0*cs, rs, cs);
+	// A22 <- A22 - L21 A12
+	auto j1 = j0 + jb;
+	np::_blas::gemm(m - j1, cn, jb, Dtype(-1), a + j1*rs + j0*cs, rs, cs, a + j0*rs + c0*cs, rs, cs,
+			Dtype(1), a + j1*rs + c0*cs, rs, cs);
       }
 
       template <class Dtype>
-      vector<int> _forward_elimination(matrix<Dtype>& Ab) {
+      void _lu_factor_blocked(Dtype* a, np::intp rs, np::intp cs, np::intp m, np::intp ncols, int* p,
+			      int workers=1) {
+	// Right-looking blocked LU factorization with partial pivoting, done in-place.
+	// The first m columns of the m x ncols matrix `a` are factorized
+	// and the remaining ones (e.g. right-hand sides) are eliminated alongside.
+	//
+	// The columns to the right of the current panel are split into block columns, which are
+	// updated by independent tasks. The task of the next block column also factorizes it
+	// as the next panel (lookahead), so that the panel factorization is overlapped
+	// with the rest of the trailing update instead of serializing the steps.
+	// The result does not depend on the number of workers.
+	auto nb = lu_block_size;
+	std::vector<np::intp> ipiv(m);
+	if (m == 0)
+	  return;
+
+	_lu_factor_panel(a, rs, cs, m, 0, std::min(nb, m), 0, std::min(nb, m), ipiv.data());
+	for (np::intp j0=0; j0<m; j0+=nb) {
+	  auto jb = std::min(nb, m - j0);
+	  auto j1 = j0 + jb;
+
+	  // block columns to the right; their boundaries coincide with the panels up to column m
+	  std::vector<np::intp> bounds;
+	  for (auto c=j1; c<ncols; c+=nb)
+	    bounds.push_back(c);
+	  bounds.push_back(ncols);
+	  if (m < ncols and j1 < m)
+	    bounds.insert(std::lower_bound(bounds.begin(), bounds.end(), m), m);
+	  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+	  np::_parallel::parallel_for(bounds.size() - 1, workers, [&](np::intp t) {
+	    auto c0 = bounds[t], cn = bounds[t+1] - c0;
+	    _lu_update_block_column(a, rs, cs, m, c0, cn, j0, jb, ipiv.data());
+	    if (t == 0 and c0 < m) // lookahead
+	      _lu_factor_panel(a, rs, cs, m, c0, cn, c0, cn, ipiv.data());
+	  });
+	}
+
+	// Finally, the interchanges are applied to L, to the left of each panel.
+	np::_parallel::parallel_for((m + nb - 1) / nb, workers, [&](np::intp t) {
+	  auto c0 = t * nb, cn = std::min(nb, m - c0);
+	  _lu_swap_rows(a, rs, cs, c0, cn, c0 + cn, m, ipiv.data());
+	});
+
+	for (np::intp i=0; i<m; i++)
+	  std::swap(p[i], p[ipiv[i]]);
+      }
+
+      template <class Dtype>
+      vector<int> _forward_elimination(matrix<Dtype>& Ab, int workers=1) {
 	// Let us consider the following equation:
 	//   Ax = b.
 	// This function conducts forward elimination in-place.
 	//
 	// parameter:
 	// Ab : coefficient matrix A or augmented coefficient matrix (A|b)
+	// workers : the number of threads (-1 means all the CPUs)
       
 	// !add exception handling here!
 	static_assert(std::is_floating_point_v<Dtype>);
 
-	int i;
 	auto n = Ab.shape(0);
 	auto p = np::array(python::range(n)); // permutation
-
-	for (i=0; i<n-1; i++) {
-	  auto sl = slice(str(i) + ":");
-	  auto lower_right_block = Ab(sl, sl);
-	  auto p_sliced = p(sl);
-	  _forward_elimination_step(lower_right_block, p_sliced);
-	}
-
+	_lu_factor_blocked(Ab.data(), Ab.strides()[0], Ab.strides()[1], n, Ab.shape(1), p.data(), workers);
 	return p;
       }
 
+      template <class Dtype>
+      void _triangular_solve(const matrix<Dtype>& A, matrix<Dtype>& b, bool lower, bool diag_is_1) {
+	// solves A x = b in-place for all the columns of b at once
+	auto n = A.shape(0);
+	auto nrhs = b.ndim() == 1 ? 1 : b.shape(1);
+	auto csb = b.ndim() == 1 ? 1 : b.strides()[1];
+	np::_blas::trsm(lower, diag_is_1, n, nrhs, A.data(), A.strides()[0], A.strides()[1],
+			b.data(), b.strides()[0], csb);
+      }
+
       template <class Dtype>
       void _backward_substitution_upper(const matrix<Dtype>& A, matrix<Dtype>& b, bool diag_is_1=false) {
 	// conducts backward substitution in-place.
 	//
 	// parameters:
 	// A : UPPER triangular coefficient matrix
-	// b : constant vector
-
-	auto n = A.shape(0);
-	for (int i=n-1; i>=0; i--) {
-	  auto sl = slice(str(i+1) + ":");
-	  if (i < n-1) {
-	    auto sum = np::matmul(A(i, sl).copy(), b(sl).copy());
-	    b(i) -= sum;
-	  }
-	  if (not diag_is_1)
-	    b(i) /= A(i, i);
-	}
+	// b : constant vector or matrix whose columns are right-hand sides
+	_triangular_solve(A, b, false, diag_is_1);
       }
 
       template <class Dtype>
@@ -84,18 +160,8 @@ namespace scipy {
 	//
 	// parameters:
 	// A : LOWER triangular coefficient matrix
-	// b : constant vector
-
-	auto n = A.shape(0);
-	for (int i=0; i<n; i++) {
-	  auto sl = slice(":" + str(i));
-	  if (i > 0) {
-	    auto sum = np::matmul(A(i, sl).copy(), b(sl).copy());
-	    b(i) -= sum;
-	  }
-	  if (not diag_is_1)
-	    b(i) /= A(i, i);
-	}      
+	// b : constant vector or matrix whose columns are right-hand sides
+	_triangular_solve(A, b, true, diag_is_1);
       }
 
       template <class Dtype>
@@ -103,17 +169,53 @@ namespace scipy {
 
 	matrix<Dtype> LU;
 	vector<int> p;
+	std::vector<np::intp> swaps; // p as successive row interchanges, for solves in place
 
 	LU_decomposition(const matrix<Dtype>& LU_, const vector<int>& p_)
-	  : LU(LU_), p(p_) {}
+	  : LU(LU_), p(p_) {
+	  _make_swaps();
+	}
       
-	LU_decomposition(const matrix<Dtype>& a, bool overwrite_a=false) {
+	LU_decomposition(const matrix<Dtype>& a, bool overwrite_a=false, int workers=1) {
 	  if (overwrite_a)
 	    LU = a;
 	  else
 	    LU = a.copy();
 	  assert(LU.shape(0) == LU.shape(1));
-	  p = _forward_elimination(LU);
+	  p = _forward_elimination(LU, workers);
+	  _make_swaps();
+	}
+
+	void _make_swaps() {
+	  // swapping rows i and swaps[i] for i = 0, ..., n-1 in turn brings row p(i) to row i
+	  auto n = p.size();
+	  std::vector<np::intp> row(n), pos(n); // the original row at each position and its inverse
+	  std::iota(row.begin(), row.end(), np::intp(0));
+	  std::iota(pos.begin(), pos.end(), np::intp(0));
+	  swaps.resize(n);
+	  for (np::intp i=0; i<n; i++) {
+	    auto j = pos[p.data()[i*p.strides()[0]]];
+	    swaps[i] = j;
+	    std::swap(row[i], row[j]);
+	    pos[row[i]] = i;
+	    pos[row[j]] = j;
+	  }
+	}
+
+	void solve_into(const Dtype* b, np::intp rsb, np::intp csb, Dtype* x, np::intp rsx, np::intp csx, np::intp nrhs) const {
+	  // x = inv(A) b for n x nrhs matrices b and x, which may be the same storage. Only the
+	  // factorization is read, so that concurrent calls are safe, and nothing is allocated but
+	  // the packing buffers of the products for several right-hand sides.
+	  auto n = LU.shape(0);
+	  if (x != b)
+	    for (np::intp i=0; i<n; i++)
+	      for (np::intp j=0; j<nrhs; j++)
+		x[i*rsx + j*csx] = b[i*rsb + j*csb];
+	  for (np::intp i=0; i<n; i++)
+	    if (swaps[i] != i)
+	      np::_blas::swap(nrhs, x + i*rsx, csx, x + swaps[i]*rsx, csx);
+	  np::_blas::trsm(true, true, n, nrhs, LU.data(), LU.strides()[0], LU.strides()[1], x, rsx, csx);
+	  np::_blas::trsm(false, false, n, nrhs, LU.data(), LU.strides()[0], LU.strides()[1], x, rsx, csx);
 	}
 
 	matrix<Dtype> L() const {
@@ -142,29 +244,35 @@ namespace scipy {
 	}
 
 	matrix<Dtype> permute(const matrix<Dtype>& b, bool overwrite_b=false) const {
-	  auto tmp = b.copy();
+	  auto src = overwrite_b ? b.copy() : b;
 	  matrix<Dtype> rhs;
 	  if (overwrite_b)
 	    rhs = b;
 	  else
-	    rhs = np::empty(b.shape());
-
-	  auto itr = p.begin();
-	  auto end = p.end();
-	  int i = 0;
-	  for(; itr!=end; itr++, i++)
-	    rhs(i) = tmp(*itr);
-
+	    rhs = np::empty<Dtype>(b.shape());
+
+	  // rhs(i) = src(p(i)), row by row on the raw memory
+	  auto n = b.shape(0);
+	  auto ncols = b.ndim() == 1 ? 1 : b.shape(1);
+	  auto cs_src = b.ndim() == 1 ? 1 : src.strides()[1];
+	  auto cs_rhs = b.ndim() == 1 ? 1 : rhs.strides()[1];
+	  auto p_i = p.data();
+	  auto p_stride = p.strides()[0];
+	  for (np::intp i=0; i<n; i++) {
+	    auto row_src = src.data() + p_i[i*p_stride] * src.strides()[0];
+	    auto row_rhs = rhs.data() + i * rhs.strides()[0];
+	    for (np::intp j=0; j<ncols; j++)
+	      row_rhs[j*cs_rhs] = row_src[j*cs_src];
+	  }
 	  return rhs;
 	}
 
 	matrix<Dtype> solve(const matrix<Dtype>& b, bool overwrite_b=false) const {	
-	  auto rhs = permute(b, overwrite_b);
-	
-	  _backward_substitution_lower(LU, rhs, true);
-	  _backward_substitution_upper(LU, rhs, false);
-
-	  return rhs;
+	  auto x = overwrite_b ? b : np::empty<Dtype>(b.shape());
+	  auto nrhs = b.ndim() == 1 ? 1 : b.shape(1);
+	  solve_into(b.data(), b.strides()[0], b.ndim() == 1 ? 1 : b.strides()[1],
+		     x.data(), x.strides()[0], x.ndim() == 1 ? 1 : x.strides()[1], nrhs);
+	  return x;
 	}
       };
 
@@ -220,33 +328,497 @@ namespace scipy {
       };
 
 
+      // Stacks of small matrices, (..., n, n), are factored batch_lanes<Dtype> at a time in an
+      // interleaved layout, the element (i, j) of the l-th matrix of a group being at
+      // (i*n + j)*W + l, so that every step of the elimination runs across the matrices in SIMD
+      // lanes. The groups are handed out to the threads in turn. Pivoting is done per matrix.
+
+      template <class Dtype>
+      constexpr np::intp batch_lanes = 32 / sizeof(Dtype); // one AVX register
+
+      template <class Dtype, class Function>
+      void _for_batch_groups(np::intp batch, int workers, Function f) {
+	// f(m0, count) for the groups of up to batch_lanes consecutive matrices, concurrently
+	constexpr np::intp W = batch_lanes<Dtype>, groups_per_task = 16;
+	auto n_groups = (batch + W - 1) / W;
+	np::_parallel::parallel_for((n_groups + groups_per_task - 1) / groups_per_task, workers, [&](np::intp t) {
+	  for (auto g=t*groups_per_task; g<std::min(n_groups, (t + 1)*groups_per_task); g++)
+	    f(g*W, std::min(W, batch - g*W));
+	});
+      }
+
+      template <np::intp W, class T>
+      void _interleave(const T* src, np::intp size, np::intp count, const T* pad, T* dst) {
+	// the `count` arrays of `size` elements at src into dst, the missing lanes filled by `pad`
+	for (np::intp e=0; e<size; e++)
+	  for (np::intp l=0; l<W; l++)
+	    dst[e*W + l] = l < count ? src[l*size + e] : pad[e];
+      }
+
+      template <np::intp W, class T>
+      void _deinterleave(const T* src, np::intp size, np::intp count, T* dst) {
+	for (np::intp l=0; l<count; l++)
+	  for (np::intp e=0; e<size; e++)
+	    dst[l*size + e] = src[e*W + l];
+      }
+
+      template <np::intp W, class Dtype>
+      void _lu_factor_interleaved(Dtype* a, np::intp n, int* p) {
+	// LU with partial pivoting of W interleaved matrices of order n, in place.
+	// p(i*W + l) receives the permutation of the l-th one, as LU_decomposition::p.
+	for (np::intp i=0; i<n; i++)
+	  for (np::intp l=0; l<W; l++)
+	    p[i*W + l] = i;
+	for (np::intp k=0; k<n; k++) {
+	  for (np::intp l=0; l<W; l++) {
+	    auto piv = k;
+	    for (auto i=k+1; i<n; i++)
+	      if (std::abs(a[(i*n + k)*W + l]) > std::abs(a[(piv*n + k)*W + l]))
+		piv = i;
+	    if (piv == k)
+	      continue;
+	    for (np::intp j=0; j<n; j++)
+	      std::swap(a[(k*n + j)*W + l], a[(piv*n + j)*W + l]);
+	    std::swap(p[k*W + l], p[piv*W + l]);
+	  }
+	  auto a_k = a + k*n*W;
+	  for (auto i=k+1; i<n; i++) {
+	    auto a_i = a + i*n*W;
+	    Dtype l_ik[W];
+	    for (np::intp l=0; l<W; l++) {
+	      l_ik[l] = a_k[k*W + l] == Dtype(0) ? Dtype(0) : a_i[k*W + l] / a_k[k*W + l];
+	      a_i[k*W + l] = l_ik[l];
+	    }
+	    for (auto j=k+1; j<n; j++)
+	      for (np::intp l=0; l<W; l++)
+		a_i[j*W + l] -= l_ik[l] * a_k[j*W + l];
+	  }
+	}
+      }
+
+      template <np::intp W, class Dtype>
+      void _lu_solve_interleaved(const Dtype* lu, const int* p, np::intp n, const Dtype* b, np::intp k, Dtype* x) {
+	// x_l = inv(A_l) b_l for k interleaved right-hand sides per matrix, b_l(i, c) being at
+	// (i*k + c)*W + l
+	for (np::intp i=0; i<n; i++)
+	  for (np::intp c=0; c<k; c++)
+	    for (np::intp l=0; l<W; l++)
+	      x[(i*k + c)*W + l] = b[(p[i*W + l]*k + c)*W + l];
+	// L y = P b
+	for (np::intp i=0; i<n; i++)
+	  for (np::intp j=0; j<i; j++)
+	    for (np::intp c=0; c<k; c++)
+	      for (np::intp l=0; l<W; l++)
+		x[(i*k + c)*W + l] -= lu[(i*n + j)*W + l] * x[(j*k + c)*W + l];
+	// U x = y
+	for (auto i=n-1; i>=0; i--) {
+	  for (auto j=i+1; j<n; j++)
+	    for (np::intp c=0; c<k; c++)
+	      for (np::intp l=0; l<W; l++)
+		x[(i*k + c)*W + l] -= lu[(i*n + j)*W + l] * x[(j*k + c)*W + l];
+	  for (np::intp c=0; c<k; c++)
+	    for (np::intp l=0; l<W; l++)
+	      x[(i*k + c)*W + l] /= lu[(i*n + i)*W + l];
+	}
+      }
+
+      inline np::intp _check_stack(const np::shape_type& shape) {
+	// the order of the matrices of a stack (..., n, n)
+	auto d = shape.size();
+	if (d < 2 or shape[d - 1] != shape[d - 2])
+	  throw std::invalid_argument("ValueError: expected a stack of square matrices (..., n, n)");
+	return shape[d - 1];
+      }
+
+      template <class Dtype>
+      np::ndarray<Dtype> _c_contiguous(const np::ndarray<Dtype>& a) {
+	// `a` itself if its elements are contiguous in C order, otherwise a contiguous copy
+	np::intp expected = 1;
+	for (auto d=np::intp(a.ndim())-1; d>=0; d--) {
+	  if (a.shape(d) != 1 and a.strides()[d] != expected)
+	    return a.copy();
+	  expected *= a.shape(d);
+	}
+	return a;
+      }
+
+      template <class Dtype, class Function>
+      void _batched_lu(const matrix<Dtype>& a, int workers, Function f) {
+	// f(m0, count, lu, p) with the interleaved factorizations of the matrices m0, ..., m0+count-1
+	constexpr auto W = batch_lanes<Dtype>;
+	auto n = _check_stack(a.shape());
+	auto batch = a.size() / std::max<np::intp>(n * n, 1);
+	auto ac = _c_contiguous(a);
+	std::vector<Dtype> eye(n * n);
+	for (np::intp i=0; i<n; i++)
+	  eye[i*n + i] = Dtype(1);
+	_for_batch_groups<Dtype>(batch, workers, [&](np::intp m0, np::intp count) {
+	  std::vector<Dtype> lu(n * n * W);
+	  std::vector<int> p(n * W);
+	  _interleave<W>(ac.data() + m0*n*n, n*n, count, eye.data(), lu.data());
+	  _lu_factor_interleaved<W>(lu.data(), n, p.data());
+	  f(m0, count, lu.data(), p.data());
+	});
+      }
+
+      template <class Dtype>
+      std::tuple<matrix<Dtype>, vector<int>> _batched_lu_factor(const matrix<Dtype>& a, int workers=1) {
+	constexpr auto W = batch_lanes<Dtype>;
+	auto shape = a.shape();
+	auto n = _check_stack(shape);
+	auto lu = np::empty<Dtype>(shape);
+	shape.pop_back();
+	auto p = np::empty<int>(shape);
+	_batched_lu(a, workers, [&](np::intp m0, np::intp count, const Dtype* lu_, const int* p_) {
+	  _deinterleave<W>(lu_, n*n, count, lu.data() + m0*n*n);
+	  _deinterleave<W>(p_, n, count, p.data() + m0*n);
+	});
+	return {lu, p};
+      }
+
+      template <class Dtype>
+      matrix<Dtype> _batched_lu_solve(const matrix<Dtype>& lu, const vector<int>& p, const matrix<Dtype>& b, int workers=1) {
+	// b is (..., n) for one right-hand side per matrix or (..., n, k)
+	constexpr auto W = batch_lanes<Dtype>;
+	auto n = _check_stack(lu.shape());
+	auto batch = lu.size() / std::max<np::intp>(n * n, 1);
+	if ((b.ndim() != lu.ndim() - 1 and b.ndim() != lu.ndim()) or b.shape(lu.ndim() - 2) != n
+	    or p.size() != batch * n)
+	  throw std::invalid_argument("ValueError: incompatible dimensions");
+	for (np::intp d=0; d<lu.ndim() - 2; d++)
+	  if (b.shape(d) != lu.shape(d))
+	    throw std::invalid_argument("ValueError: the stacks of b and lu differ");
+	auto k = b.ndim() == lu.ndim() ? b.shape(b.ndim() - 1) : 1;
+	auto luc = _c_contiguous(lu);
+	auto pc = _c_contiguous(p);
+	auto bc = _c_contiguous(b);
+	auto x = np::empty<Dtype>(b.shape());
+	std::vector<Dtype> eye(n * n);
+	std::vector<int> iota(n);
+	for (np::intp i=0; i<n; i++) {
+	  eye[i*n + i] = Dtype(1);
+	  iota[i] = i;
+	}
+	std::vector<Dtype> zeros(n * k);
+	_for_batch_groups<Dtype>(batch, workers, [&](np::intp m0, np::intp count) {
+	  std::vector<Dtype> lu_(n * n * W), b_(n * k * W), x_(n * k * W);
+	  std::vector<int> p_(n * W);
+	  _interleave<W>(luc.data() + m0*n*n, n*n, count, eye.data(), lu_.data());
+	  _interleave<W>(pc.data() + m0*n, n, count, iota.data(), p_.data());
+	  _interleave<W>(bc.data() + m0*n*k, n*k, count, zeros.data(), b_.data());
+	  _lu_solve_interleaved<W>(lu_.data(), p_.data(), n, b_.data(), k, x_.data());
+	  _deinterleave<W>(x_.data(), n*k, count, x.data() + m0*n*k);
+	});
+	return x;
+      }
+
+      template <class Dtype>
+      matrix<Dtype> _batched_inv(const matrix<Dtype>& a, int workers=1) {
+	constexpr auto W = batch_lanes<Dtype>;
+	auto n = _check_stack(a.shape());
+	auto ret = np::empty<Dtype>(a.shape());
+	std::vector<Dtype> eye(n * n * W);
+	for (np::intp i=0; i<n; i++)
+	  for (np::intp l=0; l<W; l++)
+	    eye[(i*n + i)*W + l] = Dtype(1);
+	_batched_lu(a, workers, [&](np::intp m0, np::intp count, const Dtype* lu, const int* p) {
+	  std::vector<Dtype> x(n * n * W);
+	  _lu_solve_interleaved<W>(lu, p, n, eye.data(), n, x.data());
+	  _deinterleave<W>(x.data(), n*n, count, ret.data() + m0*n*n);
+	});
+	return ret;
+      }
+
+      template <class Dtype>
+      std::tuple<np::ndarray<Dtype>, np::ndarray<Dtype>> _batched_slogdet(const matrix<Dtype>& a, int workers=1) {
+	// the sign and the log of the absolute value of the determinants, of shape a.shape[:-2]
+	constexpr auto W = batch_lanes<Dtype>;
+	auto n = _check_stack(a.shape());
+	auto shape = a.shape();
+	shape.resize(shape.size() - 2);
+	auto sign = np::empty<Dtype>(shape), logdet = np::empty<Dtype>(shape);
+	_batched_lu(a, workers, [&](np::intp m0, np::intp count, const Dtype* lu, const int* p) {
+	  std::vector<char> visited(n);
+	  for (np::intp l=0; l<count; l++) {
+	    // the parity of the permutation from its cycles
+	    Dtype s = 1, log_abs = 0;
+	    std::fill(visited.begin(), visited.end(), 0);
+	    for (np::intp i=0; i<n; i++) {
+	      if (visited[i])
+		continue;
+	      np::intp length = 0;
+	      for (auto j=i; not visited[j]; j=p[j*W + l], length++)
+		visited[j] = 1;
+	      if (length % 2 == 0)
+		s = -s;
+	    }
+	    for (np::intp i=0; i<n; i++) {
+	      auto u_ii = lu[(i*n + i)*W + l];
+	      s = u_ii < Dtype(0) ? -s : s;
+	      log_abs += std::log(std::abs(u_ii));
+	    }
+	    sign.data()[m0 + l] = std::isinf(log_abs) and log_abs < 0 ? Dtype(0) : s;
+	    logdet.data()[m0 + l] = log_abs;
+	  }
+	});
+	return {sign, logdet};
+      }
+
+      constexpr int refinement_maxiter = 30;
+
+      template <class Residual, class Dtype>
+      std::tuple<matrix<Dtype>, int> _mixed_precision_solve(const matrix<Dtype>& a, const matrix<Dtype>& b, int workers=1) {
+	// Iterative refinement as LAPACK's dsgesv: A is factored in float, which halves the memory
+	// traffic of the factorization, and x is refined by solving A d = b - A x with that
+	// factorization, the residual being computed from A itself in the precision `Residual`.
+	// Returns x and the number of refinement steps, or -1 if the factorization in float failed
+	// to converge and A was factored in Dtype instead.
+	static_assert(std::is_floating_point_v<Dtype>);
+	if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	  throw std::invalid_argument("ValueError: expected square matrix");
+	if (b.shape(0) != a.shape(0))
+	  throw std::invalid_argument("ValueError: incompatible dimensions");
+	auto n = a.shape(0);
+	auto nrhs = b.ndim() == 1 ? 1 : b.shape(1);
+	auto rs = a.strides()[0], cs = a.strides()[1];
+	auto rsb = b.strides()[0], csb = b.ndim() == 1 ? 1 : b.strides()[1];
+	auto a_ = a.data(), b_ = b.data();
+
+	// |A|_inf, and A in float unless it overflows
+	auto a32 = np::empty<float>({n, n});
+	Dtype a_norm = 0;
+	bool overflow = false;
+	for (np::intp i=0; i<n; i++) {
+	  Dtype row_sum = 0;
+	  for (np::intp j=0; j<n; j++) {
+	    auto a_ij = a_[i*rs + j*cs];
+	    row_sum += std::abs(a_ij);
+	    overflow |= std::abs(a_ij) > std::numeric_limits<float>::max();
+	    a32.data()[i*n + j] = float(a_ij);
+	  }
+	  a_norm = std::max(a_norm, row_sum);
+	}
+
+	auto x = np::zeros<Dtype>(b.ndim() == 1 ? np::shape_type{n} : np::shape_type{n, nrhs});
+	if (not overflow) {
+	  auto LU = LU_decomposition<float>(a32, true, workers);
+	  std::vector<Residual> r(n * nrhs);
+	  auto d = np::empty<float>(x.shape());
+	  auto tol = std::sqrt(Dtype(n)) * std::numeric_limits<Dtype>::epsilon() * a_norm;
+	  for (int iter=0; iter<=refinement_maxiter; iter++) {
+	    // r = b - A x
+	    for (np::intp i=0; i<n; i++)
+	      for (np::intp j=0; j<nrhs; j++)
+		r[i*nrhs + j] = Residual(b_[i*rsb + j*csb]);
+	    if (iter > 0)
+	      np::_blas::gemm(n, nrhs, n, Residual(-1), a_, rs, cs, x.data(), nrhs, np::intp(1), Residual(1), r.data(), nrhs, np::intp(1));
+	    // converged if |r|_inf <= sqrt(n) eps |A|_inf |x|_inf for every column
+	    bool converged = iter > 0;
+	    for (np::intp j=0; j<nrhs and converged; j++) {
+	      Dtype r_norm = 0, x_norm = 0;
+	      for (np::intp i=0; i<n; i++) {
+		r_norm = std::max(r_norm, Dtype(std::abs(r[i*nrhs + j])));
+		x_norm = std::max(x_norm, std::abs(x.data()[i*nrhs + j]));
+	      }
+	      converged = r_norm <= tol * x_norm;
+	    }
+	    if (converged)
+	      return {x, iter - 1};
+	    if (iter == refinement_maxiter)
+	      break;
+	    // x += inv(A) r in float
+	    std::transform(r.begin(), r.end(), d.data(), [](Residual r_i) { return float(r_i); });
+	    d = LU.solve(d, true);
+	    bool finite = true;
+	    for (np::intp k=0; k<n*nrhs; k++) {
+	      x.data()[k] += Dtype(d.data()[k]);
+	      finite &= std::isfinite(x.data()[k]);
+	    }
+	    if (not finite)
+	      break;
+	  }
+	}
+	// the working precision as a fallback
+	return {LU_decomposition<Dtype>(a, false, workers).solve(b), -1};
+      }
+
+      constexpr np::intp cholesky_block_size = 128;
+
+      template <class Dtype>
+      np::intp _cholesky_unblocked(Dtype* a, np::intp rs, np::intp cs, np::intp n) {
+	// Overwrites the lower triangle of an n x n SPD matrix with its Cholesky factor L.
+	// Returns k > 0 if the leading minor of order k is not positive definite, 0 otherwise.
+	for (np::intp j=0; j<n; j++) {
+	  auto a_j = a + j*rs;
+	  auto d = a_j[j*cs] - np::_blas::dot<Dtype>(j, a_j, cs, a_j, cs);
+	  if (not (d > 0))
+	    return j + 1;
+	  auto l_jj = std::sqrt(d);
+	  a_j[j*cs] = l_jj;
+	  for (np::intp i=j+1; i<n; i++) {
+	    auto a_i = a + i*rs;
+	    a_i[j*cs] = (a_i[j*cs] - np::_blas::dot<Dtype>(j, a_i, cs, a_j, cs)) / l_jj;
+	  }
+	}
+	return 0;
+      }
+
+      template <class Dtype>
+      np::intp _cholesky_blocked(Dtype* a, np::intp rs, np::intp cs, np::intp n, int workers=1) {
+	// Right-looking blocked Cholesky factorization A = L L^T, done in-place.
+	// Only the lower triangle is read and written; pass swapped strides to work on the upper one.
+	// The panel solve and the symmetric trailing update are split into block rows,
+	// which are processed in parallel.
+	auto nb = cholesky_block_size;
+	for (np::intp j0=0; j0<n; j0+=nb) {
+	  auto jb = std::min(nb, n - j0);
+	  auto j1 = j0 + jb;
+	  auto a11 = a + j0*rs + j0*cs;
+	  if (auto info = _cholesky_unblocked(a11, rs, cs, jb))
+	    return j0 + info;
+	  if (j1 == n)
+	    break;
+
+	  auto n_blocks = (n - j1 + nb - 1) / nb;
+	  // A21 <- A21 inv(L11)^T, by forward substitution along the rows of A21
+	  np::_parallel::parallel_for(n_blocks, workers, [&](np::intp t) {
+	    auto i0 = j1 + t*nb, ib = std::min(nb, n - i0);
+	    for (np::intp i=i0; i<i0+ib; i++) {
+	      auto a_i = a + i*rs + j0*cs;
+	      for (np::intp j=0; j<jb; j++) {
+		auto l_j = a11 + j*rs;
+		a_i[j*cs] = (a_i[j*cs] - np::_blas::dot<Dtype>(j, a_i, cs, l_j, cs)) / l_j[j*cs];
+	      }
+	    }
+	  });
+	  // A22 <- A22 - A21 A21^T on the lower triangle, by block columns
+	  np::_parallel::parallel_for(n_blocks, workers, [&](np::intp t) {
+	    auto i0 = j1 + t*nb, ib = std::min(nb, n - i0);
+	    auto a21_i = a + i0*rs + j0*cs;
+	    // below the diagonal block
+	    np::_blas::gemm(n - i0 - ib, ib, jb, Dtype(-1), a21_i + ib*rs, rs, cs, a21_i, cs, rs,
+			    Dtype(1), a + (i0+ib)*rs + i0*cs, rs, cs);
+	    // the diagonal block goes through a buffer not to touch the upper triangle
+	    std::vector<Dtype> buf(ib * ib);
+	    np::_blas::gemm(ib, ib, jb, Dtype(1), a21_i, rs, cs, a21_i, cs, rs, Dtype(0), buf.data(), ib, 1);
+	    for (np::intp i=0; i<ib; i++)
+	      for (np::intp j=0; j<=i; j++)
+		a[(i0+i)*rs + (i0+j)*cs] -= buf[i*ib + j];
+	  });
+	}
+	return 0;
+      }
+
+      template <class Dtype>
+      struct Cholesky_decomposition {
+
+	matrix<Dtype> c; // the factor in one triangle, the other one is left untouched
+	bool lower;
+
+	Cholesky_decomposition(const matrix<Dtype>& c_, bool lower_)
+	  : c(c_), lower(lower_) {}
+
+	Cholesky_decomposition(const matrix<Dtype>& a, bool lower_, bool overwrite_a, int workers=1)
+	  : lower(lower_) {
+	  static_assert(std::is_floating_point_v<Dtype>);
+	  if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	    throw std::invalid_argument("ValueError: expected square matrix");
+	  if (overwrite_a)
+	    c = a;
+	  else
+	    c = a.copy();
+	  auto [rs, cs] = _strides_of_L();
+	  if (auto info = _cholesky_blocked(c.data(), rs, cs, c.shape(0), workers))
+	    throw std::runtime_error("LinAlgError: " + std::to_string(info)
+				     + "-th leading minor of the array is not positive definite");
+	}
+
+	std::pair<np::intp, np::intp> _strides_of_L() const {
+	  // U is stored as L = U^T
+	  auto rs = c.strides()[0], cs = c.strides()[1];
+	  return lower ? std::make_pair(rs, cs) : std::make_pair(cs, rs);
+	}
+
+	matrix<Dtype> solve(const matrix<Dtype>& b, bool overwrite_b=false) const {
+	  matrix<Dtype> x;
+	  if (overwrite_b)
+	    x = b;
+	  else
+	    x = b.copy();
+	  auto [rs, cs] = _strides_of_L();
+	  auto n = c.shape(0);
+	  auto nrhs = x.ndim() == 1 ? 1 : x.shape(1);
+	  auto csx = x.ndim() == 1 ? 1 : x.strides()[1];
+	  // L L^T x = b
+	  np::_blas::trsm(true, false, n, nrhs, c.data(), rs, cs, x.data(), x.strides()[0], csx);
+	  np::_blas::trsm(false, false, n, nrhs, c.data(), cs, rs, x.data(), x.strides()[0], csx);
+	  return x;
+	}
+      };
+
+
       // iterative solvers
 
       template <class Dtype>
       struct _iterative_solver {
 
-	matrix<Dtype> a;
+	LinearOperator<Dtype> a;
 	vector<Dtype> b;
 	np::float_ eps;
 	np::float_ norm_b;
 	int n;
+	std::vector<Dtype> residual; // A x - b as of the last _converge
+	int maxiter = 0; // the cap on the iterations, 0 for the default of the method
+	std::function<void(np::float_)> callback; // called with the relative residual norm after every iteration
+	int info = 0; // as in SciPy, 0 on convergence, or the number of iterations done without it
             
-	_iterative_solver(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
-	  : a(a_), b(b_), eps(eps_), norm_b(norm(b)), n(a.shape(1)) {}
-
-	bool _converge(const vector<Dtype>& x, bool relative=true) const {
-	  auto residual = np::matmul(a, x) - b;
-	  auto error = norm(residual);
-	  if (relative) {
-	    error /= norm_b;
+	_iterative_solver(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
+	  : a(a_), b(b_.copy()), eps(eps_), norm_b(norm(b)), n(a.shape[1]), residual(n) {
+	  if (not a.matvec)
+	    throw std::invalid_argument("ValueError: the operator has no matvec");
+	}
+
+	virtual int _default_maxiter() const { return 10 * n; }
+
+	np::float_ _relative(np::float_ error) const {
+	  return norm_b > 0 ? error / norm_b : error;
+	}
+
+	bool _done(int iter, np::float_ error, bool report=true) {
+	  // Reports the relative residual norm after `iter` iterations. True on convergence, or when
+	  // the iterations run out, which is recorded in `info`.
+	  if (callback and report and iter > 0)
+	    callback(error);
+	  if (error < eps) {
+	    info = 0;
+	    return true;
+	  }
+	  if (iter >= (maxiter > 0 ? maxiter : _default_maxiter())) {
+	    info = iter;
+	    return true;
 	  }
-	  return error < eps;
+	  return false;
+	}
+
+	np::float_ _residual_norm(const Dtype* x, bool relative=true) {
+	  a.matvec(x, residual.data());
+	  np::_blas::axpy(n, Dtype(-1), b.data(), 1, residual.data(), 1);
+	  auto error = np::_blas::nrm2(n, residual.data(), 1);
+	  return relative ? _relative(error) : error;
+	}
+
+	bool _converge(const Dtype* x, bool relative=true) {
+	  return _residual_norm(x, relative) < eps;
+	}
+
+	bool _converge(const vector<Dtype>& x, bool relative=true) {
+	  return _converge(x.data(), relative);
 	}
 
 	virtual void _solve_impl(vector<Dtype>& x)  = 0;
 
 	vector<Dtype> solve(const python::NoneType None=python::None) {
-	  auto x = np::zeros({this->n});
+	  auto x = np::zeros<Dtype>({this->n});
 	  _solve_impl(x);
 	  return x;
 	}
@@ -260,168 +832,840 @@ namespace scipy {
 
       template <class Dtype, bool _use_x2>
       struct _stationary_iterative_solver: public _iterative_solver<Dtype> {
+	// Rows are relaxed in their natural order, or color by color after set_multicolor, in which
+	// case the rows of a color, being uncoupled, are relaxed concurrently by `workers` threads.
+
+	std::vector<Dtype> diag; // A(i, i)
+	np::float_ omega = 1; // the relaxation factor
+	int workers = 1;
+	std::vector<np::intp> color_ptr, color_rows; // rows grouped by color, empty for the natural order
+
+	_stationary_iterative_solver(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
+	  : _iterative_solver<Dtype>(a_, b_, eps_), diag(this->n) {
+	  if (not this->a.diagonal)
+	    throw std::invalid_argument("ValueError: the stationary iterative methods need the diagonal of the operator");
+	  if (not _use_x2 and not this->a.row_dot)
+	    throw std::invalid_argument("ValueError: the Gauss-Seidel and SOR methods need the rows of the operator");
+	  for (int i=0; i<this->n; i++)
+	    diag[i] = this->a.diagonal(i);
+	}
+
+	void set_multicolor(const sparse::spmatrix<Dtype>& a_) {
+	  // orders the rows by a greedy coloring of the sparsity graph of `a_`
+	  auto csr = a_.tocsr();
+	  auto csc = csr.tocsc();
+	  sparse::_sparse::_color_rows(this->n, csr.indptr.data(), csr.indices.data(), csc.indptr.data(), csc.indices.data(),
+				       color_ptr, color_rows);
+	}
+
+	template <class Function>
+	void _for_row_chunks(np::intp n_rows, Function f) {
+	  // f(r0, r1) on chunks of rows, concurrently if there are enough of them
+	  constexpr np::intp chunk = 4096;
+	  np::_parallel::parallel_for((n_rows + chunk - 1) / chunk, workers, [&](np::intp c) {
+	    f(c * chunk, std::min(n_rows, (c + 1) * chunk));
+	  });
+	}
+
+	Dtype _get_new_x_i(const Dtype* x_old, int i) const {
+	  // (b(i) - sum_{j != i} A(i, j) x_old(j)) / A(i, i)
+	  auto sum = this->a.row_dot(i, x_old) - diag[i] * x_old[i];
+	  return (this->b.data()[i] - sum) / diag[i];
+	}
 
-	using _iterative_solver<Dtype>::_iterative_solver;
+	void _relax(Dtype* x, np::intp i) const {
+	  auto y = _get_new_x_i(x, i);
+	  x[i] = omega == 1 ? y : x[i] * (1 - omega) + y * omega;
+	}
 
-	template <class ArrayIterator>
-	auto _get_new_x_i(ArrayIterator itr_a, ArrayIterator itr_b,
-			  ArrayIterator itr_x_old, ArrayIterator itr_x_new,
-			  int n, int i) -> typename ArrayIterator::value_type {
-	  auto init = typename ArrayIterator::value_type(0);
-	  auto sum = std::inner_product(itr_a, itr_a + i, itr_x_old, init);
-	  sum += std::inner_product(itr_a + i+1, itr_a + n, itr_x_old + i+1, init);
-	  return (*itr_b - sum) / *(itr_a + i);
+	int _default_maxiter() const override {
+	  // no cap as they may converge slowly
+	  return std::numeric_limits<int>::max();
 	}
 
-	using ArrayIterator = typename np::ndarray<Dtype>::iterator;
-	virtual void _update_x_i(ArrayIterator itr_a, ArrayIterator itr_b,
-				 ArrayIterator itr_x, ArrayIterator itr_x2,
-				 int n, int i) = 0;
+	virtual void _sweep(Dtype* x, Dtype* x2) {
+	  // one sweep in place
+	  if (color_rows.empty()) {
+	    for (int i=0; i<this->n; i++)
+	      _relax(x, i);
+	    return;
+	  }
+	  for (size_t c=0; c+1<color_ptr.size(); c++) {
+	    auto rows = color_rows.data() + color_ptr[c];
+	    _for_row_chunks(color_ptr[c + 1] - color_ptr[c], [&](np::intp r0, np::intp r1) {
+	      for (auto r=r0; r<r1; r++)
+		_relax(x, rows[r]);
+	    });
+	  }
+	}
 
-	void _solve_impl(vector<Dtype>& x) {
+	void _solve_impl(vector<Dtype>& x) override {
 	  // preparation
-	  auto x2 = x; // buffer
-	  auto n = this->a.shape(0);
-	  auto itr_x = x.begin();
-	  auto itr_x2 = itr_x;
-
-	  if constexpr (_use_x2) {
-	      x2 = np::empty(x.shape());
-	      itr_x2 = x2.begin();
-	    }
+	  std::vector<Dtype> x2(_use_x2 ? this->n : 0); // buffer
+	  auto x_ = x.data(), x2_ = x2.data();
 
 	  // loop
-	  while (not this->_converge(x)) {
-	    auto itr_a = this->a.begin();
-	    auto itr_b = this->b.begin();
-      
-	    for (int i=0; i<n; i++) {
-	      _update_x_i(itr_a, itr_b, itr_x, itr_x2, n, i);
-	      itr_a += n;
-	      ++itr_b;
-	    }
-
-	    if constexpr (_use_x2) { // Jacobi
-		// swap
-		auto tmp = itr_x;
-		itr_x = itr_x2;
-		itr_x2 = tmp;
-	      }  
+	  for (int iter=0; not this->_done(iter, this->_residual_norm(x_)); iter++) {
+	    _sweep(x_, x2_);
+	    if constexpr (_use_x2) // Jacobi
+	      std::swap(x_, x2_);
 	  }
+	  if (x_ != x.data())
+	    std::copy(x_, x_ + this->n, x.data());
 	}
       };
 
       template <class Dtype>
       struct Jacobi: public _stationary_iterative_solver<Dtype, true> {
+	// The products by A are those of the operator, which are parallel for sparse matrices.
 
-	Jacobi(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
+	Jacobi(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
 	  : _stationary_iterative_solver<Dtype, true>(a_, b_, eps_) {}
 
-	using ArrayIterator = typename np::ndarray<Dtype>::iterator;
-	void _update_x_i(ArrayIterator itr_a, ArrayIterator itr_b,
-			 ArrayIterator itr_x, ArrayIterator itr_x2,
-			 int n, int i) override {
-	  *(itr_x2 + i) = this->_get_new_x_i(itr_a, itr_b, itr_x, itr_x2, n, i);
+	Jacobi(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
+	  : Jacobi(LinearOperator<Dtype>(a_), b_, eps_) {}
+
+	Jacobi(const sparse::spmatrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default, int workers_=-1)
+	  : Jacobi(LinearOperator<Dtype>(a_, workers_), b_, eps_) {
+	  this->workers = workers_;
+	}
+
+	void _sweep(Dtype* x, Dtype* x2) override {
+	  // x2 = x - D^-1 (A x - b) with the residual left by _converge, needing no rows of A
+	  auto r = this->residual.data();
+	  auto d = this->diag.data();
+	  this->_for_row_chunks(this->n, [=](np::intp r0, np::intp r1) {
+	    for (auto i=r0; i<r1; i++)
+	      x2[i] = x[i] - r[i] / d[i];
+	  });
 	}
       };
 
       template <class Dtype>
       struct Gauss_Seidel: public _stationary_iterative_solver<Dtype, false> {
+	// With `multicolor`, the rows are relaxed color by color (red-black for a 5-point stencil),
+	// which converges at about the same rate as the natural order and runs on `workers` threads.
 
-	Gauss_Seidel(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
+	Gauss_Seidel(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
 	  : _stationary_iterative_solver<Dtype, false>(a_, b_, eps_) {}
-      
-	using ArrayIterator = typename np::ndarray<Dtype>::iterator;
-	void _update_x_i(ArrayIterator itr_a, ArrayIterator itr_b,
-			 ArrayIterator itr_x, ArrayIterator itr_x2,
-			 int n, int i) override {
-	  *(itr_x + i) = this->_get_new_x_i(itr_a, itr_b, itr_x, itr_x, n, i);
+
+	Gauss_Seidel(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
+	  : Gauss_Seidel(LinearOperator<Dtype>(a_), b_, eps_) {}
+
+	Gauss_Seidel(const sparse::spmatrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+		     bool multicolor=false, int workers_=-1)
+	  : Gauss_Seidel(LinearOperator<Dtype>(a_, workers_), b_, eps_) {
+	  this->workers = workers_;
+	  if (multicolor)
+	    this->set_multicolor(a_);
 	}
       };
 
       template <class Dtype>
       struct SOR: public _stationary_iterative_solver<Dtype, false> {
+	// as Gauss_Seidel, with the relaxation factor omega
+
+	SOR(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ omega_, np::float_ eps_=eps_default)
+	  : _stationary_iterative_solver<Dtype, false>(a_, b_, eps_) {
+	  this->omega = omega_;
+	}
 
-	np::float_ omega;
-      
 	SOR(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ omega_, np::float_ eps_=eps_default)
-	  : _stationary_iterative_solver<Dtype, false>(a_, b_, eps_), omega(omega_) {}
-      
-	using ArrayIterator = typename np::ndarray<Dtype>::iterator;
-	void _update_x_i(ArrayIterator itr_a, ArrayIterator itr_b,
-			 ArrayIterator itr_x, ArrayIterator itr_x2,
-			 int n, int i) override {
-	  auto y = this->_get_new_x_i(itr_a, itr_b, itr_x, itr_x, n, i);
-	  *(itr_x + i) = *(itr_x + i) * (1 - omega) + y * omega;
+	  : SOR(LinearOperator<Dtype>(a_), b_, omega_, eps_) {}
+
+	SOR(const sparse::spmatrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ omega_, np::float_ eps_=eps_default,
+	    bool multicolor=false, int workers_=-1)
+	  : SOR(LinearOperator<Dtype>(a_, workers_), b_, omega_, eps_) {
+	  this->workers = workers_;
+	  if (multicolor)
+	    this->set_multicolor(a_);
 	}
       };
 
 
       template <class Dtype>
       struct ConjugateGradient: public _iterative_solver<Dtype> {
-      
-	ConjugateGradient(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default)
-	  : _iterative_solver<Dtype>(a_, b_, eps_) {}
+	// The preconditioned conjugate gradient method for a symmetric positive definite A.
+	// M applies the preconditioner, an approximation of inv(A), as in SciPy (none if it has no matvec).
+	// The iteration vectors are allocated once, and the convergence is judged by the recursively
+	// updated residual, which costs no extra matvec.
+
+	LinearOperator<Dtype> M;
+	std::vector<Dtype> r, z, p, q;
+
+	ConjugateGradient(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+			  const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : _iterative_solver<Dtype>(a_, b_, eps_), M(M_), r(this->n), z(M_.matvec ? this->n : 0), p(this->n), q(this->n) {}
+
+	ConjugateGradient(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+			  const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : ConjugateGradient(LinearOperator<Dtype>(a_), b_, eps_, M_) {}
+
+	ConjugateGradient(const sparse::spmatrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+			  const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : ConjugateGradient(LinearOperator<Dtype>(a_), b_, eps_, M_) {}
 
 	void _solve_impl(vector<Dtype>& x) override {
-	  // init
-	  auto r = this->b - np::matmul(this->a, x); // residual = steepest decent direction
-	  auto p = r; // decent direction = A-orthogonalization of r
-	  np::float_ r_dot_p, p_dot_Ap; // inner products
-	  np::float_ alpha; // step size of gradient decent
-	  np::float_ beta; // a factor in Gram-Schmidt orthogonormalization
+	  auto n = this->n;
+	  auto x_ = x.data(), b_ = this->b.data(), r_ = r.data(), p_ = p.data(), q_ = q.data();
+	  auto z_ = M.matvec ? z.data() : r_; // z = inv(M) r
+	  int iter = 0;
+
+	  // r = b - A x
+	  this->a.matvec(x_, q_);
+	  for (int i=0; i<n; i++)
+	    r_[i] = b_[i] - q_[i];
+	  if (this->_done(iter, this->_relative(np::_blas::nrm2(n, r_, 1))))
+	    return;
+	  if (M.matvec)
+	    M.matvec(r_, z_);
+	  std::copy(z_, z_ + n, p_);
+	  auto rz = np::_blas::dot<Dtype>(n, r_, 1, z_, 1);
+
+	  while (true) {
+	    this->a.matvec(p_, q_);
+	    auto pq = np::_blas::dot<Dtype>(n, p_, 1, q_, 1);
+	    if (pq == Dtype(0)) {
+	      this->info = -10;
+	      break;
+	    }
+	    auto alpha = rz / pq; // step size
+	    // x += alpha p, r -= alpha q in one pass, with |r|^2
+	    Dtype rr = 0;
+	    for (int i=0; i<n; i++) {
+	      x_[i] += alpha * p_[i];
+	      r_[i] -= alpha * q_[i];
+	      rr += r_[i] * r_[i];
+	    }
+	    if (this->_done(++iter, this->_relative(std::sqrt(rr))))
+	      break;
+	    if (M.matvec)
+	      M.matvec(r_, z_);
+	    auto rz_new = M.matvec ? np::_blas::dot<Dtype>(n, r_, 1, z_, 1) : rr;
+	    auto beta = rz_new / rz; // makes the new direction A-orthogonal to the previous ones
+	    rz = rz_new;
+	    for (int i=0; i<n; i++)
+	      p_[i] = z_[i] + beta * p_[i];
+	  }
+	}
+      };
 
-	  // loop
-	  while (not this->_converge(x)) {
-	    auto Ap = np::matmul(this->a, p);
-	    r_dot_p = np::dot(r, p);
-	    p_dot_Ap = np::dot(p, Ap);
-
-	    alpha = r_dot_p / p_dot_Ap;
-	    x += alpha * p;
-	    r -= alpha * Ap;
-      	  
-	    r_dot_p = np::dot(r, p);
-
-	    beta = r_dot_p / p_dot_Ap;
-	    p = r - beta * p;
+
+      template <class Dtype>
+      struct GMRES: public _iterative_solver<Dtype> {
+	// The restarted GMRES(m) method for a general nonsingular A, preconditioned on the right by M
+	// so that the residual it minimizes is the one of the original system. The Krylov basis,
+	// the Hessenberg matrix and the Givens rotations reducing it are allocated once for all the
+	// restarts, and the true residual is recomputed at each of them. `maxiter` counts the inner
+	// iterations, i.e. the products by A.
+
+	LinearOperator<Dtype> M;
+	int m; // the restart length
+	std::vector<Dtype> V; // (m+1) x n, the orthonormal basis by rows
+	std::vector<Dtype> H; // (m+1) x m, the Hessenberg matrix reduced to upper triangular
+	std::vector<Dtype> cs, sn, g, h, u, z;
+
+	GMRES(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default, int restart=20,
+	      const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : _iterative_solver<Dtype>(a_, b_, eps_), M(M_), m(std::max(1, std::min(restart, this->n))),
+	    V((m + 1) * this->n), H((m + 1) * m), cs(m), sn(m), g(m + 1), h(m + 1), u(this->n), z(this->n) {}
+
+	GMRES(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default, int restart=20,
+	      const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : GMRES(LinearOperator<Dtype>(a_), b_, eps_, restart, M_) {}
+
+	GMRES(const sparse::spmatrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default, int restart=20,
+	      const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : GMRES(LinearOperator<Dtype>(a_), b_, eps_, restart, M_) {}
+
+	void _orthogonalize(int j, Dtype* w) {
+	  // w -= V(:j+1)^T V(:j+1) w twice (classical Gram-Schmidt with reorthogonalization),
+	  // accumulating the coefficients in H(:j+1, j)
+	  auto n = this->n;
+	  for (int i=0; i<=j; i++)
+	    H[i*m + j] = Dtype(0);
+	  for (int pass=0; pass<2; pass++) {
+	    np::_blas::gemv(j + 1, n, Dtype(1), V.data(), n, 1, w, 1, Dtype(0), h.data(), 1);
+	    np::_blas::gemv(n, j + 1, Dtype(-1), V.data(), 1, n, h.data(), 1, Dtype(1), w, 1);
+	    for (int i=0; i<=j; i++)
+	      H[i*m + j] += h[i];
+	  }
+	}
+
+	void _rotate(int j) {
+	  // applies the previous rotations to H(:, j), then zeroes H(j+1, j) with a new one
+	  for (int i=0; i<j; i++) {
+	    auto t = cs[i] * H[i*m + j] + sn[i] * H[(i + 1)*m + j];
+	    H[(i + 1)*m + j] = -sn[i] * H[i*m + j] + cs[i] * H[(i + 1)*m + j];
+	    H[i*m + j] = t;
+	  }
+	  auto r = std::hypot(H[j*m + j], H[(j + 1)*m + j]);
+	  cs[j] = r == Dtype(0) ? Dtype(1) : H[j*m + j] / r;
+	  sn[j] = r == Dtype(0) ? Dtype(0) : H[(j + 1)*m + j] / r;
+	  H[j*m + j] = r;
+	  H[(j + 1)*m + j] = Dtype(0);
+	  g[j + 1] = -sn[j] * g[j];
+	  g[j] *= cs[j];
+	}
+
+	void _update(int k, Dtype* x) {
+	  // x += inv(M) V(:k)^T y with H(:k, :k) y = g(:k)
+	  for (int i=k-1; i>=0; i--) {
+	    auto sum = g[i];
+	    for (int l=i+1; l<k; l++)
+	      sum -= H[i*m + l] * g[l];
+	    g[i] = H[i*m + i] == Dtype(0) ? Dtype(0) : sum / H[i*m + i];
+	  }
+	  np::_blas::gemv(this->n, k, Dtype(1), V.data(), 1, this->n, g.data(), 1, Dtype(0), u.data(), 1);
+	  if (M.matvec)
+	    M.matvec(u.data(), z.data());
+	  np::_blas::axpy(this->n, Dtype(1), M.matvec ? z.data() : u.data(), 1, x, 1);
+	}
+
+	void _solve_impl(vector<Dtype>& x) override {
+	  static_assert(std::is_floating_point_v<Dtype>);
+	  auto n = this->n;
+	  auto x_ = x.data(), b_ = this->b.data(), v0 = V.data();
+	  int iter = 0;
+
+	  while (true) {
+	    // r = b - A x
+	    this->a.matvec(x_, v0);
+	    for (int i=0; i<n; i++)
+	      v0[i] = b_[i] - v0[i];
+	    auto beta = np::_blas::nrm2(n, v0, 1);
+	    if (this->_done(iter, this->_relative(beta), false))
+	      return;
+	    np::_blas::scal(n, Dtype(1) / beta, v0, 1);
+	    std::fill(g.begin(), g.end(), Dtype(0));
+	    g[0] = beta;
+
+	    int j = 0;
+	    bool done = false;
+	    while (j < m and not done) {
+	      // v_{j+1} = A inv(M) v_j, orthonormalized
+	      auto v = v0 + j*n, w = v + n;
+	      if (M.matvec)
+		M.matvec(v, z.data());
+	      this->a.matvec(M.matvec ? z.data() : v, w);
+	      _orthogonalize(j, w);
+	      auto h_next = np::_blas::nrm2(n, w, 1);
+	      H[(j + 1)*m + j] = h_next;
+	      if (h_next != Dtype(0)) // otherwise the solution lies in the basis
+		np::_blas::scal(n, Dtype(1) / h_next, w, 1);
+	      _rotate(j);
+	      j++;
+	      done = this->_done(++iter, this->_relative(std::abs(g[j])));
+	    }
+	    _update(j, x_);
 	  }
 	}
       };
+
+      template <class Dtype>
+      struct BiCGSTAB: public _iterative_solver<Dtype> {
+	// The biconjugate gradient stabilized method of van der Vorst for a general nonsingular A,
+	// preconditioned on the right by M. It needs two products by A per iteration but, unlike
+	// GMRES, a fixed amount of memory, all of which is allocated once. A breakdown sets info to -10.
+
+	LinearOperator<Dtype> M;
+	std::vector<Dtype> r, r_hat, p, v, s, t, p_hat, s_hat;
+
+	BiCGSTAB(const LinearOperator<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+		 const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : _iterative_solver<Dtype>(a_, b_, eps_), M(M_), r(this->n), r_hat(this->n), p(this->n), v(this->n),
+	    s(this->n), t(this->n), p_hat(M_.matvec ? this->n : 0), s_hat(M_.matvec ? this->n : 0) {}
+
+	BiCGSTAB(const matrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+		 const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : BiCGSTAB(LinearOperator<Dtype>(a_), b_, eps_, M_) {}
+
+	BiCGSTAB(const sparse::spmatrix<Dtype>& a_, const vector<Dtype>& b_, np::float_ eps_=eps_default,
+		 const LinearOperator<Dtype>& M_=LinearOperator<Dtype>())
+	  : BiCGSTAB(LinearOperator<Dtype>(a_), b_, eps_, M_) {}
+
+	void _solve_impl(vector<Dtype>& x) override {
+	  auto n = this->n;
+	  auto x_ = x.data(), b_ = this->b.data(), r_ = r.data(), p_ = p.data(), v_ = v.data();
+	  auto s_ = s.data(), t_ = t.data();
+	  auto p_hat_ = M.matvec ? p_hat.data() : p_; // inv(M) p
+	  auto s_hat_ = M.matvec ? s_hat.data() : s_; // inv(M) s
+	  int iter = 0;
+
+	  // r = b - A x
+	  this->a.matvec(x_, r_);
+	  for (int i=0; i<n; i++)
+	    r_[i] = b_[i] - r_[i];
+	  if (this->_done(iter, this->_relative(np::_blas::nrm2(n, r_, 1))))
+	    return;
+	  std::copy(r_, r_ + n, r_hat.data());
+	  Dtype rho = 1, alpha = 1, omega = 1;
+
+	  while (true) {
+	    auto rho_new = np::_blas::dot<Dtype>(n, r_hat.data(), 1, r_, 1);
+	    if (rho_new == Dtype(0) or omega == Dtype(0)) {
+	      this->info = -10;
+	      return;
+	    }
+	    if (iter == 0)
+	      std::copy(r_, r_ + n, p_);
+	    else {
+	      auto beta = (rho_new / rho) * (alpha / omega);
+	      for (int i=0; i<n; i++)
+		p_[i] = r_[i] + beta * (p_[i] - omega * v_[i]);
+	    }
+	    rho = rho_new;
+	    if (M.matvec)
+	      M.matvec(p_, p_hat_);
+	    this->a.matvec(p_hat_, v_);
+	    auto r_hat_v = np::_blas::dot<Dtype>(n, r_hat.data(), 1, v_, 1);
+	    if (r_hat_v == Dtype(0)) {
+	      this->info = -10;
+	      return;
+	    }
+	    alpha = rho / r_hat_v;
+	    // s = r - alpha v, x += alpha inv(M) p, with |s|^2
+	    Dtype ss = 0;
+	    for (int i=0; i<n; i++) {
+	      s_[i] = r_[i] - alpha * v_[i];
+	      x_[i] += alpha * p_hat_[i];
+	      ss += s_[i] * s_[i];
+	    }
+	    if (this->_relative(std::sqrt(ss)) < this->eps) {
+	      this->_done(++iter, this->_relative(std::sqrt(ss)));
+	      return;
+	    }
+	    if (M.matvec)
+	      M.matvec(s_, s_hat_);
+	    this->a.matvec(s_hat_, t_);
+	    auto tt = np::_blas::dot<Dtype>(n, t_, 1, t_, 1);
+	    omega = tt == Dtype(0) ? Dtype(0) : np::_blas::dot<Dtype>(n, t_, 1, s_, 1) / tt;
+	    // x += omega inv(M) s, r = s - omega t, with |r|^2
+	    Dtype rr = 0;
+	    for (int i=0; i<n; i++) {
+	      x_[i] += omega * s_hat_[i];
+	      r_[i] = s_[i] - omega * t_[i];
+	      rr += r_[i] * r_[i];
+	    }
+	    if (this->_done(++iter, this->_relative(std::sqrt(rr))))
+	      return;
+	  }
+	}
+      };
+
+
+      // preconditioners for ConjugateGradient, given as operators applying inv(M)
+
+      template <class Dtype>
+      np::intp _find_diagonal(const sparse::csr_matrix<Dtype>& a, np::intp i) {
+	// position of A(i, i) in `a.data`, whose rows are sorted
+	auto idx = a.indices.data();
+	auto pos = std::lower_bound(idx + a.indptr.data()[i], idx + a.indptr.data()[i + 1], i) - idx;
+	if (pos == a.indptr.data()[i + 1] or idx[pos] != i or a.data.data()[pos] == Dtype(0))
+	  throw std::runtime_error("LinAlgError: zero diagonal element " + std::to_string(i));
+	return pos;
+      }
+
+      template <class Dtype>
+      LinearOperator<Dtype> _ssor_preconditioner(const sparse::csr_matrix<Dtype>& a, np::float_ omega) {
+	// M = omega/(2-omega) (D/omega + L) inv(D/omega) (D/omega + U), applied by a forward
+	// and a backward sweep in place
+	auto n = a.shape[0];
+	std::vector<np::intp> diag_pos(n);
+	for (np::intp i=0; i<n; i++)
+	  diag_pos[i] = _find_diagonal(a, i);
+	auto matvec = [a, diag_pos, omega, n](const Dtype* r, Dtype* z) {
+	  auto p = a.indptr.data();
+	  auto idx = a.indices.data();
+	  auto val = a.data.data();
+	  for (np::intp i=0; i<n; i++) {
+	    Dtype sum = r[i];
+	    for (auto k=p[i]; k<diag_pos[i]; k++)
+	      sum -= val[k] * z[idx[k]];
+	    z[i] = omega * sum / val[diag_pos[i]];
+	  }
+	  for (np::intp i=0; i<n; i++)
+	    z[i] *= val[diag_pos[i]] / omega;
+	  for (np::intp i=n-1; i>=0; i--) {
+	    Dtype sum = z[i];
+	    for (auto k=diag_pos[i]+1; k<p[i + 1]; k++)
+	      sum -= val[k] * z[idx[k]];
+	    z[i] = omega * sum / val[diag_pos[i]];
+	  }
+	  for (np::intp i=0; i<n; i++)
+	    z[i] *= (2 - omega) / omega;
+	};
+	return LinearOperator<Dtype>(a.shape, matvec);
+      }
+
+      template <class Dtype>
+      LinearOperator<Dtype> _ichol0_preconditioner(const sparse::csr_matrix<Dtype>& a) {
+	// M = L L^T with the incomplete Cholesky factor L on the sparsity pattern of the lower
+	// triangle of A, whose rows are computed in turn as in the left-looking Cholesky method
+	auto n = a.shape[0];
+	auto ap = a.indptr.data();
+	auto aidx = a.indices.data();
+	auto aval = a.data.data();
+	auto p = std::make_shared<std::vector<np::intp>>(n + 1);
+	auto idx = std::make_shared<std::vector<sparse::index_type>>();
+	auto val = std::make_shared<std::vector<Dtype>>();
+	auto& lp = *p;
+	auto& li = *idx;
+	auto& lv = *val;
+	lp[0] = 0;
+	for (np::intp i=0; i<n; i++) {
+	  for (auto k=ap[i]; k<ap[i + 1] and aidx[k] <= i; k++) {
+	    li.push_back(aidx[k]);
+	    lv.push_back(aval[k]);
+	  }
+	  lp[i + 1] = li.size();
+	  if (li.empty() or li.back() != i)
+	    throw std::runtime_error("LinAlgError: zero diagonal element " + std::to_string(i));
+	}
+	for (np::intp i=0; i<n; i++) {
+	  for (auto k=lp[i]; k<lp[i + 1]; k++) {
+	    auto j = li[k];
+	    // L(i, j) -= sum_{l < j} L(i, l) L(j, l), merging the sorted rows i and j
+	    Dtype sum = 0;
+	    auto u = lp[i], v = lp[j];
+	    while (u < k and v < lp[j + 1] - 1) {
+	      if (li[u] == li[v])
+		sum += lv[u++] * lv[v++];
+	      else if (li[u] < li[v])
+		u++;
+	      else
+		v++;
+	    }
+	    if (j < i)
+	      lv[k] = (lv[k] - sum) / lv[lp[j + 1] - 1];
+	    else if (lv[k] - sum > Dtype(0))
+	      lv[k] = std::sqrt(lv[k] - sum);
+	    else
+	      throw std::runtime_error("LinAlgError: the incomplete Cholesky factorization broke down at " + std::to_string(i)
+				       + "; the matrix is not positive definite enough");
+	  }
+	}
+	auto matvec = [p, idx, val, n](const Dtype* r, Dtype* z) {
+	  auto lp = p->data();
+	  auto li = idx->data();
+	  auto lv = val->data();
+	  // L y = r
+	  for (np::intp i=0; i<n; i++) {
+	    Dtype sum = r[i];
+	    for (auto k=lp[i]; k<lp[i + 1] - 1; k++)
+	      sum -= lv[k] * z[li[k]];
+	    z[i] = sum / lv[lp[i + 1] - 1];
+	  }
+	  // L^T z = y, by columns of L^T
+	  for (np::intp i=n-1; i>=0; i--) {
+	    z[i] /= lv[lp[i + 1] - 1];
+	    for (auto k=lp[i]; k<lp[i + 1] - 1; k++)
+	      z[li[k]] -= lv[k] * z[i];
+	  }
+	};
+	return LinearOperator<Dtype>(a.shape, matvec);
+      }
       
     }
 
 
-    // template <class Dtype1, class Dtype2>
-    // auto solve(const ndarray<Dtype1>& a, const ndarray<Dtype2>& b) -> ndarray<float64> {
-    //   // ...
-    // }
-
     template <class Dtype>
-    std::tuple<matrix<Dtype>, vector<int>> lu_factor(const matrix<Dtype>& a, bool overwrite_a=false) {
-      auto lu = _solve::LU_decomposition(a, overwrite_a);
+    std::tuple<matrix<Dtype>, vector<int>> lu_factor(const matrix<Dtype>& a, bool overwrite_a=false, int workers=1) {
+      // `workers` is the number of threads used for the factorization; -1 means all the CPUs.
+      // A stack of matrices (..., n, n) gives the stacked factors and permutations (..., n), the
+      // matrices being spread over the threads.
+      _solve::_check_stack(a.shape());
+      if (a.ndim() > 2)
+	return _solve::_batched_lu_factor(a, workers);
+      auto lu = _solve::LU_decomposition(a, overwrite_a, workers);
       return {lu.LU, lu.p};
     }
 
     template <class Dtype>
-    matrix<Dtype> lu_solve(const std::tuple<matrix<Dtype>, vector<int>>& lu_and_piv, const matrix<Dtype>& b, bool overwrite_b=False) {
+    matrix<Dtype> lu_solve(const std::tuple<matrix<Dtype>, vector<int>>& lu_and_piv, const matrix<Dtype>& b, bool overwrite_b=False,
+			   int workers=1) {
+      // for stacked factors, b is (..., n) or (..., n, k)
       auto [lu, piv] = lu_and_piv;
+      if (lu.ndim() > 2)
+	return _solve::_batched_lu_solve(lu, piv, b, workers);
       auto LU = _solve::LU_decomposition(lu, piv);
       return LU.solve(b, overwrite_b);
     }
 
     template <class Dtype>
-    matrix<Dtype> cg(const matrix<Dtype>& a, const vector<Dtype>& b, np::float_ tol=eps_default) {
-      auto CG = _solve::ConjugateGradient(a, b, tol);
-      return CG.solve();
+    struct LUSolver {
+      // A persistent LU factorization for repeated solves, as returned by factorized. Solves only
+      // read the factorization, so one handle may serve several threads at once, and those into
+      // caller-provided storage allocate nothing for a single right-hand side.
+      _solve::LU_decomposition<Dtype> lu;
+
+      LUSolver(const matrix<Dtype>& a, bool overwrite_a=false, int workers=1)
+	: lu(a, overwrite_a, workers) {}
+
+      LUSolver(const std::tuple<matrix<Dtype>, vector<int>>& lu_and_piv)
+	: lu(std::get<0>(lu_and_piv), std::get<1>(lu_and_piv)) {}
+
+      np::intp order() const { return lu.LU.shape(0); }
+
+      void operator()(const Dtype* b, Dtype* x, np::intp nrhs=1) const {
+	// x = inv(A) b for contiguous n x nrhs arrays, which may be the same
+	lu.solve_into(b, nrhs, 1, x, nrhs, 1, nrhs);
+      }
+
+      void operator()(const matrix<Dtype>& b, matrix<Dtype>& x) const {
+	// into an x of the shape of b, which may be b itself
+	if (b.ndim() < 1 or b.ndim() > 2 or b.shape(0) != order() or x.shape() != b.shape())
+	  throw std::invalid_argument("ValueError: incompatible dimensions");
+	auto nrhs = b.ndim() == 1 ? 1 : b.shape(1);
+	lu.solve_into(b.data(), b.strides()[0], b.ndim() == 1 ? 1 : b.strides()[1],
+		      x.data(), x.strides()[0], x.ndim() == 1 ? 1 : x.strides()[1], nrhs);
+      }
+
+      matrix<Dtype> operator()(const matrix<Dtype>& b) const {
+	auto x = np::empty<Dtype>(b.shape());
+	(*this)(b, x);
+	return x;
+      }
+    };
+
+    template <class Dtype>
+    LUSolver<Dtype> factorized(const matrix<Dtype>& a, bool overwrite_a=false, int workers=1) {
+      // a handle solving a x = b for any b, as SciPy's factorized
+      if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	throw std::invalid_argument("ValueError: expected square matrix");
+      return LUSolver<Dtype>(a, overwrite_a, workers);
+    }
+
+    template <class Dtype>
+    matrix<Dtype> solve(const matrix<Dtype>& a, const matrix<Dtype>& b, const std::string& mode="direct", int workers=1) {
+      // Solves a x = b for a square `a` by LU factorization.
+      // mode : "direct" to factor `a` in its own precision,
+      //        "mixed" to factor it in float32 and refine x with residuals in the precision of `a`,
+      //        which gives the same accuracy for well-conditioned systems at about the cost of
+      //        the float32 factorization (falling back to "direct" otherwise),
+      //        "mixed_extended" as "mixed" with residuals in long double.
+      if (a.ndim() != 2 or a.shape(0) != a.shape(1))
+	throw std::invalid_argument("ValueError: expected square matrix");
+      if (b.ndim() < 1 or b.shape(0) != a.shape(0))
+	throw std::invalid_argument("ValueError: incompatible dimensions");
+      if (mode == "mixed")
+	return std::get<0>(_solve::_mixed_precision_solve<Dtype>(a, b, workers));
+      if (mode == "mixed_extended")
+	return std::get<0>(_solve::_mixed_precision_solve<long double>(a, b, workers));
+      if (mode != "direct")
+	throw std::invalid_argument("ValueError: mode should be one of ['direct', 'mixed', 'mixed_extended']");
+      return _solve::LU_decomposition(a, false, workers).solve(b);
+    }
+
+    template <class Dtype>
+    std::tuple<matrix<Dtype>, bool> cho_factor(const matrix<Dtype>& a, bool lower=false, bool overwrite_a=false, int workers=1) {
+      // Only the `lower` (or upper) triangle of `a` is referenced; the other one is returned as is.
+      auto cho = _solve::Cholesky_decomposition(a, lower, overwrite_a, workers);
+      return {cho.c, cho.lower};
+    }
+
+    template <class Dtype>
+    matrix<Dtype> cho_solve(const std::tuple<matrix<Dtype>, bool>& c_and_lower, const matrix<Dtype>& b, bool overwrite_b=false) {
+      auto [c, lower] = c_and_lower;
+      auto cho = _solve::Cholesky_decomposition(c, lower);
+      return cho.solve(b, overwrite_b);
+    }
+
+    template <class Dtype>
+    matrix<Dtype> cholesky(const matrix<Dtype>& a, bool lower=false, bool overwrite_a=false, int workers=1) {
+      // returns L with a = L L^T if `lower`, otherwise U with a = U^T U
+      auto [c, lower_] = cho_factor(a, lower, overwrite_a, workers);
+      auto n = c.shape(0);
+      auto rs = c.strides()[0], cs = c.strides()[1];
+      for (np::intp i=0; i<n; i++)
+	for (np::intp j=0; j<n; j++)
+	  if (lower ? j > i : j < i)
+	    c.data()[i*rs + j*cs] = Dtype(0);
+      return c;
+    }
+
+    template <class Dtype>
+    std::tuple<matrix<Dtype>, vector<Dtype>, int> lstsq(const matrix<Dtype>& a, const matrix<Dtype>& b) {
+      // Least-squares solution of a x = b (or the minimum norm solution if a is wide) by Householder QR.
+      // Returns x, the squared residual norms of the columns of b (empty unless a is tall) and the rank.
+      // Unlike SciPy, which relies on the SVD, a rank-deficient `a` raises LinAlgError.
+      if (a.ndim() != 2)
+	throw std::invalid_argument("ValueError: expected a 2-D array");
+      auto m = a.shape(0), n = a.shape(1), k = std::min(m, n);
+      if (b.shape(0) != m)
+	throw std::invalid_argument("ValueError: incompatible dimensions");
+      auto tall = m >= n;
+      auto QR = tall ? _qr::QR_decomposition(a) : _qr::QR_decomposition(a.T());
+      auto rs = QR.qr.strides()[0], cs = QR.qr.strides()[1];
+
+      Dtype max_diag = 0;
+      for (np::intp i=0; i<k; i++)
+	max_diag = std::max(max_diag, std::abs(QR.qr.data()[i*rs + i*cs]));
+      auto tol = max_diag * std::max(m, n) * std::numeric_limits<Dtype>::epsilon();
+      for (np::intp i=0; i<k; i++)
+	if (not (std::abs(QR.qr.data()[i*rs + i*cs]) > tol))
+	  throw std::runtime_error("LinAlgError: matrix is rank deficient");
+
+      auto nrhs = b.ndim() == 1 ? 1 : b.shape(1);
+      matrix<Dtype> x;
+      vector<Dtype> residues;
+      if (tall) {
+	// R x = Q^T b
+	auto c = b.copy();
+	QR.apply_q(c, true);
+	np::_blas::trsm(false, false, n, nrhs, QR.qr.data(), rs, cs, c.data(), nrhs, 1);
+	residues = np::zeros<Dtype>({m > n ? nrhs : 0});
+	for (np::intp j=0; m>n and j<nrhs; j++)
+	  residues.data()[j] = np::_blas::dot<Dtype>(m - n, c.data() + n*nrhs + j, nrhs, c.data() + n*nrhs + j, nrhs);
+	x = b.ndim() == 1 ? c(slice(n)) : c(slice(n), slice(":"));
+	x = x.copy();
+      } else {
+	// a^T = Q R, so x = Q (R^T)^-1 b with zeros padded below
+	x = np::zeros<Dtype>(b.ndim() == 1 ? np::shape_type{n} : np::shape_type{n, nrhs});
+	std::copy(b.begin(), b.end(), x.begin());
+	np::_blas::trsm(true, false, m, nrhs, QR.qr.data(), cs, rs, x.data(), nrhs, 1);
+	QR.apply_q(x, false);
+	residues = np::zeros<Dtype>({0});
+      }
+      return {x, residues, int(k)};
+    }
+
+    // called by the iterative solvers with the relative residual norm after each iteration
+    using iteration_callback = std::function<void(np::float_)>;
+
+    template <class Operator, class Dtype>
+    matrix<Dtype> cg(const Operator& a, const vector<Dtype>& b, np::float_ tol=eps_default, int maxiter=0,
+		     const LinearOperator<Dtype>& M=LinearOperator<Dtype>(), const iteration_callback& callback=nullptr,
+		     int* info=nullptr) {
+      // a : a matrix, a sparse matrix or a LinearOperator, symmetric positive definite
+      // maxiter : the cap on the iterations, 10 n by default
+      // M : the preconditioner applying an approximation of inv(a), e.g. by ichol0_preconditioner
+      // info : set as by gmres unless null; -10 on a breakdown
+      auto CG = _solve::ConjugateGradient<Dtype>(LinearOperator<Dtype>(a), b, tol, M);
+      CG.maxiter = maxiter;
+      CG.callback = callback;
+      auto x = CG.solve();
+      if (info)
+	*info = CG.info;
+      return x;
+    }
+
+    template <class Operator, class Dtype>
+    std::tuple<vector<Dtype>, int> gmres(const Operator& a, const vector<Dtype>& b, np::float_ tol=eps_default,
+					 int restart=20, int maxiter=0, const LinearOperator<Dtype>& M=LinearOperator<Dtype>(),
+					 const iteration_callback& callback=nullptr) {
+      // a : a matrix, a sparse matrix or a LinearOperator
+      // maxiter : the cap on the inner iterations, 10 n by default; the callback gets the residual
+      //           norms estimated by the least-squares problem
+      // Returns x and, as SciPy, info = 0 on convergence or the number of iterations otherwise.
+      auto solver = _solve::GMRES<Dtype>(LinearOperator<Dtype>(a), b, tol, restart, M);
+      solver.maxiter = maxiter;
+      solver.callback = callback;
+      auto x = solver.solve();
+      return {x, solver.info};
+    }
+
+    template <class Operator, class Dtype>
+    std::tuple<vector<Dtype>, int> bicgstab(const Operator& a, const vector<Dtype>& b, np::float_ tol=eps_default,
+					    int maxiter=0, const LinearOperator<Dtype>& M=LinearOperator<Dtype>(),
+					    const iteration_callback& callback=nullptr) {
+      // as gmres; info is -10 on a breakdown
+      auto solver = _solve::BiCGSTAB<Dtype>(LinearOperator<Dtype>(a), b, tol, M);
+      solver.maxiter = maxiter;
+      solver.callback = callback;
+      auto x = solver.solve();
+      return {x, solver.info};
+    }
+
+    template <class Dtype>
+    LinearOperator<Dtype> jacobi_preconditioner(const LinearOperator<Dtype>& a) {
+      // M = diag(A)
+      if (not a.diagonal)
+	throw std::invalid_argument("ValueError: the Jacobi preconditioner needs the diagonal of the operator");
+      auto n = a.shape[0];
+      std::vector<Dtype> inv_d(n);
+      for (np::intp i=0; i<n; i++)
+	inv_d[i] = Dtype(1) / a.diagonal(i);
+      return LinearOperator<Dtype>(a.shape, [inv_d, n](const Dtype* r, Dtype* z) {
+	for (np::intp i=0; i<n; i++)
+	  z[i] = inv_d[i] * r[i];
+      });
+    }
+
+    template <class Dtype>
+    LinearOperator<Dtype> jacobi_preconditioner(const sparse::spmatrix<Dtype>& a) {
+      return jacobi_preconditioner(LinearOperator<Dtype>(a));
+    }
+
+    template <class Dtype>
+    LinearOperator<Dtype> ssor_preconditioner(const sparse::spmatrix<Dtype>& a, np::float_ omega=1.0) {
+      // symmetric SOR with the relaxation factor 0 < omega < 2
+      if (a.shape[0] != a.shape[1])
+	throw std::invalid_argument("ValueError: expected square matrix");
+      return _solve::_ssor_preconditioner(a.tocsr(), omega);
+    }
+
+    template <class Dtype>
+    LinearOperator<Dtype> ichol0_preconditioner(const sparse::spmatrix<Dtype>& a) {
+      // incomplete Cholesky factorization with no fill-in, referencing the lower triangle of `a`
+      if (a.shape[0] != a.shape[1])
+	throw std::invalid_argument("ValueError: expected square matrix");
+      return _solve::_ichol0_preconditioner(a.tocsr());
+    }
+
+    template <class Dtype>
+    auto inv(const matrix<Dtype>& a, bool overwrite_a=false, int workers=1) {
+      // a matrix is factorized on `workers` threads, and a stack (..., n, n) inverted matrix by matrix on them
+      auto n = _solve::_check_stack(a.shape());
+      if (a.ndim() > 2)
+	return _solve::_batched_inv(a, workers);
+      auto LU = _solve::LU_decomposition(a, overwrite_a, workers);
+      // the identity matrix permuted by rows
+      auto ret = np::zeros<Dtype>({n, n});
+      for (np::intp i=0; i<n; i++)
+	ret.data()[i*n + LU.p.data()[i]] = Dtype(1);
+      _solve::_backward_substitution_lower(LU.LU, ret, true);
+      _solve::_backward_substitution_upper(LU.LU, ret, false);
+      return ret;
+    }
+
+    template <class Dtype>
+    std::tuple<np::ndarray<Dtype>, np::ndarray<Dtype>> slogdet(const matrix<Dtype>& a, int workers=1) {
+      // The sign and the natural log of the absolute value of the determinant, as NumPy's slogdet,
+      // for a matrix or a stack (..., n, n), in arrays of shape a.shape[:-2] (0-d for a matrix).
+      // A singular matrix gives a sign of 0 and a log of -inf.
+      _solve::_check_stack(a.shape());
+      if (a.ndim() > 2)
+	return _solve::_batched_slogdet(a, workers);
+      auto LU = _solve::LU_decomposition(a, false, workers);
+      auto n = a.shape(0);
+      auto sign = np::empty<Dtype>(np::shape_type{}), logdet = np::empty<Dtype>(np::shape_type{});
+      Dtype s = 1, log_abs = 0;
+      for (np::intp i=0; i<n; i++) {
+	auto u_ii = LU.LU.data()[i*LU.LU.strides()[0] + i*LU.LU.strides()[1]];
+	s = u_ii < Dtype(0) ? -s : s;
+	log_abs += std::log(std::abs(u_ii));
+      }
+      // the parity of the permutation
+      auto p = LU.p.copy();
+      for (np::intp i=0; i<n; i++)
+	while (p.data()[i] != i) {
+	  std::swap(p.data()[i], p.data()[p.data()[i]]);
+	  s = -s;
+	}
+      sign.data()[0] = std::isinf(log_abs) and log_abs < 0 ? Dtype(0) : s;
+      logdet.data()[0] = log_abs;
+      return {sign, logdet};
     }
 
     template <class Dtype>
-    auto inv(const matrix<Dtype>& a, bool overwrite_a=false) {
-      assert(a.shape(0) == a.shape(1));
-      auto I = np::identity(a.shape(0));
-      auto LU = _solve::LU_decomposition(a, overwrite_a);
-      return LU.solve(I);
+    np::ndarray<Dtype> det(const matrix<Dtype>& a, int workers=1) {
+      // the determinant of a matrix or of each matrix of a stack, of shape a.shape[:-2]
+      auto [sign, logdet] = slogdet(a, workers);
+      auto ret = sign.copy();
+      for (np::intp i=0; i<ret.size(); i++)
+	ret.data()[i] *= std::exp(logdet.data()[i]);
+      return ret;
     }
     
   }
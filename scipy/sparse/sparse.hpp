@@ -0,0 +1,472 @@
+// Sparse matrices in the COO, CSR and CSC formats, as scipy.sparse.
+// Indices are 32-bit as in SciPy, which halves the memory traffic of SpMV against 64-bit ones,
+// while the row (column) pointers are np::intp so that the number of nonzeros is not limited.
+
+#pragma once
+
+namespace np = numpy;
+
+namespace scipy {
+
+  namespace sparse {
+
+    using index_type = int;
+
+    template <class Dtype> struct csr_matrix;
+    template <class Dtype> struct csc_matrix;
+    template <class Dtype> struct coo_matrix;
+
+    namespace _sparse {
+
+      /* products with fewer nonzeros are not worth the threads */
+      constexpr np::intp parallel_min_nnz = 1 << 15;
+
+      template <class Dtype>
+      void _compress(np::intp n_major, np::intp nnz, const index_type* major, const index_type* minor, const Dtype* data,
+		     np::intp* indptr, std::vector<index_type>& indices, std::vector<Dtype>& values) {
+	// Builds the compressed format (CSR if `major` holds the rows) from triplets by a counting
+	// sort, with the indices sorted and the duplicates summed.
+	std::vector<np::intp> count(n_major + 1, 0);
+	for (np::intp k=0; k<nnz; k++)
+	  count[major[k] + 1]++;
+	for (np::intp i=0; i<n_major; i++)
+	  count[i + 1] += count[i];
+	std::vector<index_type> idx(nnz);
+	std::vector<Dtype> val(nnz);
+	auto next = count;
+	for (np::intp k=0; k<nnz; k++) {
+	  auto pos = next[major[k]]++;
+	  idx[pos] = minor[k];
+	  val[pos] = data[k];
+	}
+
+	indices.clear();
+	values.clear();
+	std::vector<np::intp> order;
+	indptr[0] = 0;
+	for (np::intp i=0; i<n_major; i++) {
+	  order.resize(count[i + 1] - count[i]);
+	  std::iota(order.begin(), order.end(), count[i]);
+	  std::stable_sort(order.begin(), order.end(), [&idx](np::intp p, np::intp q) { return idx[p] < idx[q]; });
+	  for (np::intp k=0; k<np::intp(order.size()); k++) {
+	    auto p = order[k];
+	    if (k > 0 and idx[p] == indices.back())
+	      values.back() += val[p];
+	    else {
+	      indices.push_back(idx[p]);
+	      values.push_back(val[p]);
+	    }
+	  }
+	  indptr[i + 1] = indices.size();
+	}
+      }
+
+      template <class Dtype>
+      void _transpose(np::intp n_major, np::intp n_minor, const np::intp* indptr, const index_type* indices, const Dtype* data,
+		      np::intp* indptr_t, index_type* indices_t, Dtype* data_t) {
+	// CSR <-> CSC in O(nnz + n), which keeps the indices sorted
+	std::fill(indptr_t, indptr_t + n_minor + 1, np::intp(0));
+	auto nnz = indptr[n_major];
+	for (np::intp k=0; k<nnz; k++)
+	  indptr_t[indices[k] + 1]++;
+	for (np::intp j=0; j<n_minor; j++)
+	  indptr_t[j + 1] += indptr_t[j];
+	std::vector<np::intp> next(indptr_t, indptr_t + n_minor);
+	for (np::intp i=0; i<n_major; i++)
+	  for (np::intp k=indptr[i]; k<indptr[i + 1]; k++) {
+	    auto pos = next[indices[k]]++;
+	    indices_t[pos] = i;
+	    data_t[pos] = data[k];
+	  }
+      }
+
+      inline void _color_rows(np::intp n, const np::intp* indptr, const index_type* indices,
+			      const np::intp* indptr_t, const index_type* indices_t,
+			      std::vector<np::intp>& color_ptr, std::vector<np::intp>& rows) {
+	// Greedy coloring of the graph of A + A^T, given A by rows and by columns, so that no two
+	// rows of a color are coupled. Returns the rows grouped by color, color c being
+	// rows[color_ptr[c]:color_ptr[c+1]] in increasing order.
+	std::vector<np::intp> color(n, -1), last_seen;
+	auto mark = [&](np::intp i, np::intp j) {
+	  if (j != i and color[j] >= 0)
+	    last_seen[color[j]] = i;
+	};
+	for (np::intp i=0; i<n; i++) {
+	  for (auto k=indptr[i]; k<indptr[i + 1]; k++)
+	    mark(i, indices[k]);
+	  for (auto k=indptr_t[i]; k<indptr_t[i + 1]; k++)
+	    mark(i, indices_t[k]);
+	  np::intp c = 0;
+	  while (c < np::intp(last_seen.size()) and last_seen[c] == i)
+	    c++;
+	  if (c == np::intp(last_seen.size()))
+	    last_seen.push_back(-1);
+	  color[i] = c;
+	}
+	color_ptr.assign(last_seen.size() + 1, 0);
+	for (np::intp i=0; i<n; i++)
+	  color_ptr[color[i] + 1]++;
+	for (size_t c=0; c<last_seen.size(); c++)
+	  color_ptr[c + 1] += color_ptr[c];
+	rows.resize(n);
+	std::vector<np::intp> next(color_ptr.begin(), color_ptr.end() - 1);
+	for (np::intp i=0; i<n; i++)
+	  rows[next[color[i]]++] = i;
+      }
+
+      template <class T, class Dtype>
+      inline T _row_dot(np::intp begin, np::intp end, const index_type* indices, const Dtype* data, const T* x) {
+	// sum(data[k] * x[indices[k]]) with 4 independent accumulators
+	T acc[4] = {T(0), T(0), T(0), T(0)};
+	auto k = begin;
+	for (; k+4<=end; k+=4)
+	  for (np::intp l=0; l<4; l++)
+	    acc[l] += T(data[k+l]) * x[indices[k+l]];
+	for (; k<end; k++)
+	  acc[0] += T(data[k]) * x[indices[k]];
+	return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+      }
+
+      template <class Function>
+      void _for_row_blocks(np::intp n_rows, const np::intp* indptr, int workers, Function f) {
+	// Calls f(r0, r1) on blocks of consecutive rows with about the same number of nonzeros,
+	// concurrently. Every row is computed by a single thread, so results never depend on `workers`.
+	auto nnz = indptr[n_rows];
+	workers = np::_parallel::num_workers(workers);
+	if (workers <= 1 or nnz < parallel_min_nnz) {
+	  f(np::intp(0), n_rows);
+	  return;
+	}
+	np::intp n_blocks = 4 * workers;
+	std::vector<np::intp> bounds(n_blocks + 1);
+	for (np::intp t=0; t<=n_blocks; t++)
+	  bounds[t] = std::lower_bound(indptr, indptr + n_rows + 1, nnz * t / n_blocks) - indptr;
+	bounds[n_blocks] = n_rows;
+	np::_parallel::parallel_for(n_blocks, workers, [&](np::intp t) {
+	  if (bounds[t] < bounds[t + 1])
+	    f(bounds[t], bounds[t + 1]);
+	});
+      }
+
+      inline void _check_compressed(np::intp n_major, np::intp n_minor, const np::intp* indptr, const index_type* indices,
+				    const std::string& minor_name) {
+	// the checks of SciPy's check_format on compressed arrays given by the user
+	if (indptr[0] != 0)
+	  throw std::invalid_argument("ValueError: index pointer should start with 0");
+	for (np::intp i=0; i<n_major; i++)
+	  if (indptr[i + 1] < indptr[i])
+	    throw std::invalid_argument("ValueError: index pointer values must form a non-decreasing sequence");
+	for (np::intp k=0; k<indptr[n_major]; k++) {
+	  if (indices[k] < 0)
+	    throw std::invalid_argument("ValueError: " + minor_name + " index values must be >= 0");
+	  if (indices[k] >= n_minor)
+	    throw std::invalid_argument("ValueError: " + minor_name + " index values must be < " + std::to_string(n_minor));
+	}
+      }
+
+      template <class Dtype>
+      void _sum_duplicates(np::intp n_major, np::ndarray<np::intp>& indptr, np::ndarray<index_type>& indices,
+			   np::ndarray<Dtype>& data) {
+	// Sorts the indices of compressed arrays given by the user and sums their duplicates, as in
+	// those built by this library, which the triangular solves and preconditioners rely on.
+	auto p = indptr.data();
+	bool canonical = true;
+	for (np::intp i=0; i<n_major; i++)
+	  for (auto k=p[i]+1; k<p[i + 1]; k++)
+	    canonical = canonical and indices.data()[k - 1] < indices.data()[k];
+	if (canonical)
+	  return;
+	std::vector<index_type> major(p[n_major]);
+	for (np::intp i=0; i<n_major; i++)
+	  std::fill(major.begin() + p[i], major.begin() + p[i + 1], index_type(i));
+	std::vector<index_type> idx;
+	std::vector<Dtype> val;
+	_compress(n_major, p[n_major], major.data(), indices.data(), data.data(), p, idx, val);
+	indices = np::ndarray<index_type>(idx, {np::intp(idx.size())});
+	data = np::ndarray<Dtype>(val, {np::intp(val.size())});
+      }
+
+      inline void _check_shape(const np::shape_type& shape) {
+	if (shape.size() != 2 or shape[0] < 0 or shape[1] < 0)
+	  throw std::invalid_argument("ValueError: invalid shape");
+      }
+
+    }
+
+    template <class Dtype>
+    struct spmatrix {
+      // the base of the sparse formats
+
+      np::shape_type shape;
+
+      spmatrix(const np::shape_type& shape_={0, 0}) : shape(shape_) {
+	_sparse::_check_shape(shape);
+      }
+      virtual ~spmatrix() = default;
+
+      virtual np::intp nnz() const = 0;
+      virtual csr_matrix<Dtype> tocsr() const = 0;
+      virtual csc_matrix<Dtype> tocsc() const = 0;
+      virtual coo_matrix<Dtype> tocoo() const = 0;
+
+      // y = A x for contiguous x and y
+      virtual void _matvec(const Dtype* x, Dtype* y, int workers=-1) const = 0;
+
+      np::ndarray<Dtype> toarray() const {
+	auto coo = tocoo();
+	auto ret = np::zeros<Dtype>({shape[0], shape[1]});
+	for (np::intp k=0; k<coo.nnz(); k++)
+	  ret.data()[np::intp(coo.row.data()[k]) * shape[1] + coo.col.data()[k]] += coo.data.data()[k];
+	return ret;
+      }
+
+      virtual np::ndarray<Dtype> diagonal() const {
+	return tocsr().diagonal();
+      }
+
+      virtual np::ndarray<Dtype> dot(const np::ndarray<Dtype>& other, int workers=-1) const {
+	// A x for a vector or A B for a dense matrix B
+	return tocsr().dot(other, workers);
+      }
+    };
+
+    template <class Dtype>
+    struct coo_matrix: public spmatrix<Dtype> {
+      // triplets (data(k), row(k), col(k)) in any order, duplicates being summed
+
+      np::ndarray<Dtype> data;
+      np::ndarray<index_type> row, col;
+
+      coo_matrix(const np::ndarray<Dtype>& data_, const np::ndarray<index_type>& row_, const np::ndarray<index_type>& col_,
+		 const np::shape_type& shape_)
+	: spmatrix<Dtype>(shape_), data(data_.copy()), row(row_.copy()), col(col_.copy()) {
+	if (data.ndim() != 1 or row.shape() != data.shape() or col.shape() != data.shape())
+	  throw std::invalid_argument("ValueError: row, column, and data array must all be the same length");
+	for (np::intp k=0; k<nnz(); k++)
+	  if (row.data()[k] < 0 or row.data()[k] >= this->shape[0] or col.data()[k] < 0 or col.data()[k] >= this->shape[1])
+	    throw std::invalid_argument("ValueError: index out of bounds");
+      }
+
+      coo_matrix(const np::ndarray<Dtype>& a) : coo_matrix(csr_matrix<Dtype>(a).tocoo()) {}
+
+      np::intp nnz() const override { return data.shape(0); }
+
+      csr_matrix<Dtype> tocsr() const override {
+	auto indptr = np::empty<np::intp>({this->shape[0] + 1});
+	std::vector<index_type> indices;
+	std::vector<Dtype> values;
+	_sparse::_compress(this->shape[0], nnz(), row.data(), col.data(), data.data(), indptr.data(), indices, values);
+	return {np::ndarray<Dtype>(values, {np::intp(values.size())}),
+		np::ndarray<index_type>(indices, {np::intp(indices.size())}), indptr, this->shape};
+      }
+
+      csc_matrix<Dtype> tocsc() const override {
+	auto indptr = np::empty<np::intp>({this->shape[1] + 1});
+	std::vector<index_type> indices;
+	std::vector<Dtype> values;
+	_sparse::_compress(this->shape[1], nnz(), col.data(), row.data(), data.data(), indptr.data(), indices, values);
+	return {np::ndarray<Dtype>(values, {np::intp(values.size())}),
+		np::ndarray<index_type>(indices, {np::intp(indices.size())}), indptr, this->shape};
+      }
+
+      coo_matrix<Dtype> tocoo() const override { return *this; }
+
+      void _matvec(const Dtype* x, Dtype* y, int workers=-1) const override {
+	// scattered, so done sequentially; convert to CSR for repeated products
+	std::fill(y, y + this->shape[0], Dtype(0));
+	for (np::intp k=0; k<nnz(); k++)
+	  y[row.data()[k]] += data.data()[k] * x[col.data()[k]];
+      }
+
+      coo_matrix<Dtype> transpose() const {
+	return {data, col, row, {this->shape[1], this->shape[0]}};
+      }
+    };
+
+    template <class Dtype>
+    struct csr_matrix: public spmatrix<Dtype> {
+      // row i holds data(indptr(i):indptr(i+1)) in the columns indices(indptr(i):indptr(i+1)),
+      // always sorted and without duplicates
+
+      np::ndarray<Dtype> data;
+      np::ndarray<index_type> indices;
+      np::ndarray<np::intp> indptr;
+
+      csr_matrix(const np::ndarray<Dtype>& data_, const np::ndarray<index_type>& indices_, const np::ndarray<np::intp>& indptr_,
+		 const np::shape_type& shape_)
+	: spmatrix<Dtype>(shape_), data(data_.copy()), indices(indices_.copy()), indptr(indptr_.copy()) {
+	if (indptr.ndim() != 1 or indptr.shape(0) != this->shape[0] + 1)
+	  throw std::invalid_argument("ValueError: index pointer size (" + std::to_string(indptr.shape(0))
+				      + ") should be (" + std::to_string(this->shape[0] + 1) + ")");
+	if (data.ndim() != 1 or indices.shape() != data.shape() or indptr.data()[this->shape[0]] != data.shape(0))
+	  throw std::invalid_argument("ValueError: indices, data and the last index pointer must all be the same length");
+	_sparse::_check_compressed(this->shape[0], this->shape[1], indptr.data(), indices.data(), "column");
+	_sparse::_sum_duplicates(this->shape[0], indptr, indices, data);
+      }
+
+      csr_matrix(const np::ndarray<Dtype>& a) {
+	// from a dense matrix
+	if (a.ndim() != 2)
+	  throw std::invalid_argument("ValueError: expected a 2-D array");
+	this->shape = a.shape();
+	auto m = a.shape(0), n = a.shape(1), rs = a.strides()[0], cs = a.strides()[1];
+	indptr = np::empty<np::intp>({m + 1});
+	std::vector<index_type> idx;
+	std::vector<Dtype> val;
+	indptr.data()[0] = 0;
+	for (np::intp i=0; i<m; i++) {
+	  for (np::intp j=0; j<n; j++)
+	    if (a.data()[i*rs + j*cs] != Dtype(0)) {
+	      idx.push_back(j);
+	      val.push_back(a.data()[i*rs + j*cs]);
+	    }
+	  indptr.data()[i + 1] = idx.size();
+	}
+	data = np::ndarray<Dtype>(val, {np::intp(val.size())});
+	indices = np::ndarray<index_type>(idx, {np::intp(idx.size())});
+      }
+
+      csr_matrix(const spmatrix<Dtype>& a) : csr_matrix(a.tocsr()) {}
+
+      np::intp nnz() const override { return data.shape(0); }
+
+      csr_matrix<Dtype> tocsr() const override { return *this; }
+
+      csc_matrix<Dtype> tocsc() const override {
+	auto m = this->shape[0], n = this->shape[1];
+	auto indptr_t = np::empty<np::intp>({n + 1});
+	auto indices_t = np::empty<index_type>({nnz()});
+	auto data_t = np::empty<Dtype>({nnz()});
+	_sparse::_transpose(m, n, indptr.data(), indices.data(), data.data(), indptr_t.data(), indices_t.data(), data_t.data());
+	return {data_t, indices_t, indptr_t, this->shape};
+      }
+
+      coo_matrix<Dtype> tocoo() const override {
+	auto row = np::empty<index_type>({nnz()});
+	for (np::intp i=0; i<this->shape[0]; i++)
+	  std::fill(row.data() + indptr.data()[i], row.data() + indptr.data()[i + 1], index_type(i));
+	return {data, row, indices, this->shape};
+      }
+
+      csc_matrix<Dtype> transpose() const {
+	// the same arrays read by columns
+	return {data, indices, indptr, {this->shape[1], this->shape[0]}};
+      }
+
+      Dtype _row_dot(np::intp i, const Dtype* x) const {
+	// (A x)(i)
+	return _sparse::_row_dot(indptr.data()[i], indptr.data()[i + 1], indices.data(), data.data(), x);
+      }
+
+      void _matvec(const Dtype* x, Dtype* y, int workers=-1) const override {
+	auto p = indptr.data();
+	auto idx = indices.data();
+	auto val = data.data();
+	_sparse::_for_row_blocks(this->shape[0], p, workers, [=](np::intp r0, np::intp r1) {
+	  for (np::intp i=r0; i<r1; i++)
+	    y[i] = _sparse::_row_dot(p[i], p[i + 1], idx, val, x);
+	});
+      }
+
+      np::ndarray<Dtype> diagonal() const override {
+	auto k = std::min(this->shape[0], this->shape[1]);
+	auto ret = np::zeros<Dtype>({k});
+	for (np::intp i=0; i<k; i++)
+	  for (np::intp p=indptr.data()[i]; p<indptr.data()[i + 1]; p++)
+	    if (indices.data()[p] == i)
+	      ret.data()[i] += data.data()[p];
+	return ret;
+      }
+
+      np::ndarray<Dtype> dot(const np::ndarray<Dtype>& other, int workers=-1) const override {
+	// A x for a vector or A B for a dense matrix B, which are not copied if contiguous
+	if ((other.ndim() != 1 and other.ndim() != 2) or other.shape(0) != this->shape[1])
+	  throw std::invalid_argument("ValueError: dimension mismatch");
+	auto m = this->shape[0];
+	auto b = other;
+	auto contiguous = other.strides().back() == 1 and (other.ndim() == 1 or other.strides()[0] == other.shape(1));
+	if (not contiguous)
+	  b = other.copy();
+	if (other.ndim() == 1) {
+	  auto y = np::empty<Dtype>({m});
+	  _matvec(b.data(), y.data(), workers);
+	  return y;
+	}
+	// C(i, :) = sum_k A(i, k) B(k, :)
+	auto ncols = b.shape(1);
+	auto C = np::zeros<Dtype>({m, ncols});
+	auto p = indptr.data();
+	auto idx = indices.data();
+	auto val = data.data();
+	auto b_ = b.data();
+	auto c_ = C.data();
+	_sparse::_for_row_blocks(m, p, workers, [=](np::intp r0, np::intp r1) {
+	  for (np::intp i=r0; i<r1; i++)
+	    for (np::intp k=p[i]; k<p[i + 1]; k++)
+	      np::_blas::axpy(ncols, val[k], b_ + np::intp(idx[k]) * ncols, 1, c_ + i*ncols, 1);
+	});
+	return C;
+      }
+    };
+
+    template <class Dtype>
+    struct csc_matrix: public spmatrix<Dtype> {
+      // column j holds data(indptr(j):indptr(j+1)) in the rows indices(indptr(j):indptr(j+1)),
+      // always sorted and without duplicates
+
+      np::ndarray<Dtype> data;
+      np::ndarray<index_type> indices;
+      np::ndarray<np::intp> indptr;
+
+      csc_matrix(const np::ndarray<Dtype>& data_, const np::ndarray<index_type>& indices_, const np::ndarray<np::intp>& indptr_,
+		 const np::shape_type& shape_)
+	: spmatrix<Dtype>(shape_), data(data_.copy()), indices(indices_.copy()), indptr(indptr_.copy()) {
+	if (indptr.ndim() != 1 or indptr.shape(0) != this->shape[1] + 1)
+	  throw std::invalid_argument("ValueError: index pointer size (" + std::to_string(indptr.shape(0))
+				      + ") should be (" + std::to_string(this->shape[1] + 1) + ")");
+	if (data.ndim() != 1 or indices.shape() != data.shape() or indptr.data()[this->shape[1]] != data.shape(0))
+	  throw std::invalid_argument("ValueError: indices, data and the last index pointer must all be the same length");
+	_sparse::_check_compressed(this->shape[1], this->shape[0], indptr.data(), indices.data(), "row");
+	_sparse::_sum_duplicates(this->shape[1], indptr, indices, data);
+      }
+
+      csc_matrix(const np::ndarray<Dtype>& a) : csc_matrix(csr_matrix<Dtype>(a).tocsc()) {}
+
+      csc_matrix(const spmatrix<Dtype>& a) : csc_matrix(a.tocsc()) {}
+
+      np::intp nnz() const override { return data.shape(0); }
+
+      csr_matrix<Dtype> tocsr() const override {
+	auto m = this->shape[0], n = this->shape[1];
+	auto indptr_t = np::empty<np::intp>({m + 1});
+	auto indices_t = np::empty<index_type>({nnz()});
+	auto data_t = np::empty<Dtype>({nnz()});
+	_sparse::_transpose(n, m, indptr.data(), indices.data(), data.data(), indptr_t.data(), indices_t.data(), data_t.data());
+	return {data_t, indices_t, indptr_t, this->shape};
+      }
+
+      csc_matrix<Dtype> tocsc() const override { return *this; }
+
+      coo_matrix<Dtype> tocoo() const override {
+	auto col = np::empty<index_type>({nnz()});
+	for (np::intp j=0; j<this->shape[1]; j++)
+	  std::fill(col.data() + indptr.data()[j], col.data() + indptr.data()[j + 1], index_type(j));
+	return {data, indices, col, this->shape};
+      }
+
+      csr_matrix<Dtype> transpose() const {
+	return {data, indices, indptr, {this->shape[1], this->shape[0]}};
+      }
+
+      void _matvec(const Dtype* x, Dtype* y, int workers=-1) const override {
+	// scattered column by column, so done sequentially; convert to CSR for repeated products
+	std::fill(y, y + this->shape[0], Dtype(0));
+	for (np::intp j=0; j<this->shape[1]; j++)
+	  for (np::intp k=indptr.data()[j]; k<indptr.data()[j + 1]; k++)
+	    y[indices.data()[k]] += data.data()[k] * x[j];
+      }
+    };
+
+  }
+
+}
@@ -0,0 +1,48 @@
+#include <cassert>
+#include <numpy/numpy.hpp>
+using namespace python;
+namespace np = numpy;
+
+int main() {
+
+  try {
+    // 1-D & 1-D
+    auto v = np::arange(1.0, 4.0);
+    print(np::dot(v, v)); // 0-d array
+    print(np::vdot(v, v)); // scolar
+
+    // 2-D & 2-D is the matrix multiplication
+    auto a = np::arange(6.0).reshape(2, 3);
+    auto b = np::arange(12.0).reshape(3, 4);
+    print(np::dot(a, b));
+    print(np::matmul(a, b));
+    print(np::dot(a.T(), a)); // transposed views are multiplied without copying
+
+    // N-D & 1-D
+    auto c = np::arange(24.0).reshape(2, 3, 4);
+    print(np::dot(c, np::ones({4})));
+
+    // N-D & M-D: dot(c, d)[i, j, k, m] = sum(c[i, j, :] * d[k, :, m])
+    auto d = np::arange(40.0).reshape(2, 4, 5);
+    auto cd = np::dot(c, d);
+    print(cd.shape());
+    assert(cd(1, 2, 1, 3)[0] == np::vdot(c(1, 2), d(1, ":", 3)));
+
+    // tensordot
+    auto e = np::arange(60.0).reshape(3, 4, 5);
+    auto f = np::arange(24.0).reshape(4, 3, 2);
+    auto ef = np::tensordot(e, f, {{1, 0}, {0, 1}});
+    print(ef);
+    print(np::tensordot(c, c, 3)); // the same as vdot(c, c)
+    print(np::vdot(c, c));
+
+    // complex conjugate in vdot
+    auto z = np::array<np::complex_>(std::vector<np::complex_>{{1, 2}, {3, 4}});
+    print(np::vdot(z, z));
+
+    print(np::dot(a, a)); // raises ValueError
+
+  } catch (const std::exception& e) {
+    print(e);
+  }
+}
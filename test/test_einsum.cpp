@@ -0,0 +1,40 @@
+#include <numpy/numpy.hpp>
+using namespace python;
+namespace np = numpy;
+
+int main() {
+
+  try {
+    auto a = np::arange(25.0).reshape(5, 5);
+    auto b = np::arange(5.0);
+    auto c = np::arange(6.0).reshape(2, 3);
+
+    // trace, diagonal, sum & transposition
+    print(np::einsum("ii", a));
+    print(np::einsum("ii->i", a));
+    print(np::einsum("ij->", a));
+    print(np::einsum("ji", c));
+
+    // matrix-vector & matrix-matrix multiplication, outer product
+    print(np::einsum("ij,j", a, b));
+    print(np::einsum("ij,jk->ik", c, c.T()));
+    print(np::einsum("i,j", b, b));
+
+    // batched matrix multiplication
+    auto x = np::arange(24.0).reshape(2, 3, 4);
+    auto y = np::arange(40.0).reshape(2, 4, 5);
+    print(np::einsum("bij,bjk->bik", x, y));
+
+    // multi-operand contraction & the chosen order of pairwise contractions
+    auto p = np::ones({10, 200});
+    auto q = np::ones({200, 300});
+    auto r = np::ones({300, 4});
+    print(np::einsum_path("ij,jk,kl->il", p, q, r));
+    print(np::einsum("ij,jk,kl->il", p, q, r).shape());
+
+    print(np::einsum("ij,jk->ik", a, c)); // raises ValueError
+
+  } catch (const std::exception& e) {
+    print(e);
+  }
+}
@@ -39,6 +39,18 @@ int main() {
   print(R);
   print(np::matmul(Q, R));
 
+  // Householder QR
+  auto [Q_h, R_h] = scipy::linalg::qr(a1);
+  print(Q_h);
+  print(R_h);
+  print(np::matmul(Q_h, R_h));
+
+  // least squares: fit y = c0 + c1 x
+  auto X = np::ndarray<np::float_>({1, 0,   1, 1,   1, 2,   1, 3}, {4, 2});
+  auto y = np::ndarray<np::float_>({1, 3, 4, 8}, {4});
+  auto [c, residues, rank] = scipy::linalg::lstsq(X, y);
+  print(c, residues, rank);
+
   // 重複固有値がある場合のべき乗法
   auto A = np::ndarray<np::float_>({0, 0, 0, 1, -2, 0, -2, 0, 3, 1, 3, -1, -2, 0, 0, 3}, {4, 4});
   auto eigA = scipy::linalg::_eigen::PowerMethod(A);
@@ -52,4 +64,29 @@ int main() {
   //qr.set_eig();
   print(qr.eigvals);
   print(qr.eigvecs);
+
+  // Hessenberg reduction and the Francis QR algorithm
+  print(scipy::linalg::hessenberg(A));
+  print(scipy::linalg::eigvals(A));
+  auto rot = np::ndarray<np::float_>({0, -1, 1, 0}, {2, 2});
+  print(scipy::linalg::eigvals(rot)); // a complex pair
+
+  // symmetric eigenproblem
+  auto S = np::ndarray<np::float_>({2, -1, 0, 0,   -1, 2, -1, 0,   0, -1, 2, -1,   0, 0, -1, 2}, {4, 4});
+  auto [w, v] = scipy::linalg::eigh(S);
+  print(w);
+  print(v);
+  print(np::matmul(S, v) - v * w);
+  print(scipy::linalg::eigvalsh(S, true, false, {-2, -1})); // the 2 largest
+
+  // a few eigenpairs by the implicitly restarted Lanczos & Arnoldi methods
+  int n = 100;
+  scipy::linalg::matvec_type<np::float_> laplacian = [n](const np::float_* x, np::float_* y) {
+    for (int i=0; i<n; i++)
+      y[i] = 2*x[i] - (i > 0 ? x[i-1] : 0) - (i < n-1 ? x[i+1] : 0);
+  };
+  auto [w_l, v_l] = scipy::linalg::eigsh(n, laplacian, 3, "LA");
+  print(w_l);
+  print(std::get<0>(scipy::linalg::eigsh(S, 2, 1.0))); // nearest to 1 by shift-invert
+  print(std::get<0>(scipy::linalg::eigs(A, 2)));
 }
@@ -68,10 +68,49 @@ int main() {
   print(x);
   print(np::matmul(A, x));
 
+  // The same system given by a matrix-free operator
+  scipy::linalg::LinearOperator<np::float_> op({3, 3},
+    [](const np::float_* x, np::float_* y) { for (int i=0; i<3; i++) y[i] = 2*x[i] + x[0] + x[1] + x[2]; },
+    [](np::intp i) { return np::float_(3); },
+    [](np::intp i, const np::float_* x) { return 2*x[i] + x[0] + x[1] + x[2]; });
+  print(scipy::linalg::_solve::Gauss_Seidel(op, b).solve());
+  print(scipy::linalg::cg(op, b));
+
+  // GMRES and BiCGSTAB also take non-symmetric matrices; the callback gets the residual history
+  auto N = np::ndarray<np::float_>({4, 1, 0,   2, 5, 1,   0, 3, 6}, {3, 3});
+  auto c = np::ndarray<np::float_>({1, 2, 3}, {3});
+  std::vector<np::float_> history;
+  auto [y, info] = scipy::linalg::gmres(N, c, 1e-12, 20, 0, scipy::linalg::LinearOperator<np::float_>(),
+					[&](np::float_ residual) { history.push_back(residual); });
+  print(y, info, history.size());
+  print(std::get<0>(scipy::linalg::bicgstab(N, c)));
+  print(std::get<1>(scipy::linalg::bicgstab(N, c, 1e-12, 1))); // stopped after one iteration
+  int cg_info;
+  scipy::linalg::cg(A, b, 1e-12, 1, scipy::linalg::LinearOperator<np::float_>(), nullptr, &cg_info);
+  print(cg_info); // likewise
+  scipy::linalg::cg(np::ndarray<np::float_>({1, 0,   0, -1}, {2, 2}), np::ndarray<np::float_>({1, 1}, {2}), 1e-12, 0,
+		    scipy::linalg::LinearOperator<np::float_>(), nullptr, &cg_info);
+  print(cg_info); // a breakdown on an indefinite matrix
+
 
   // Let's try direct methods as well
   x = scipy::linalg::lu_solve(scipy::linalg::lu_factor(A), b);
   print(x);
+  x = scipy::linalg::lu_solve(scipy::linalg::lu_factor(A, False, -1), b); // factorized with all the CPUs
+  print(x);
+  auto solver = scipy::linalg::factorized(A); // kept for repeated solves
+  auto out = np::empty<np::float_>({3});
+  solver(b, out);
+  print(out);
+  print(scipy::linalg::solve(A, b));
+  print(scipy::linalg::solve(A, b, "mixed")); // factorized in float32, refined to double precision
+
+  // A is symmetric positive definite, so the Cholesky factorization applies
+  L = scipy::linalg::cholesky(A, True);
+  print(L);
+  print(np::matmul(L, L.T()));
+  x = scipy::linalg::cho_solve(scipy::linalg::cho_factor(A), b);
+  print(x);
 
   // Find the inverse matrix
   A = np::ndarray<np::float_>({3, 3, -5, -6,   1, 2, -3, -1,   2, 3, -5, -3,   -1, 0, 0, 1}, {4, 4});
@@ -79,4 +118,17 @@ int main() {
   auto A_inv = scipy::linalg::inv(A);
   print(A_inv);
   print(np::matmul(A, A_inv));  
+
+  // Stacks of small matrices are handled at once
+  auto S = np::ndarray<np::float_>({1, 2, 3, 4,   2, 0, 0, 2,   0, 1, 1, 0}, {3, 2, 2});
+  print(scipy::linalg::inv(S));
+  print(scipy::linalg::det(S));
+  print(scipy::linalg::lu_solve(scipy::linalg::lu_factor(S), np::ndarray<np::float_>({1, 1,   1, 1,   1, 2}, {3, 2})));
+  auto [sign, logdet] = scipy::linalg::slogdet(S);
+  print(sign, logdet);
+  try {
+    scipy::linalg::lu_solve(scipy::linalg::lu_factor(S), np::ndarray<np::float_>({1, 1,   1, 1}, {2, 2}));
+  } catch (const std::exception& e) {
+    print(e);
+  }
 }
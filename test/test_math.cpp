@@ -15,16 +15,50 @@ int main() {
   // print(time1, "micro sec.");
   print(time2, "micro sec.");
 
-  // auto c = np::ones({2, 3, 4});
-  // try {
-  //   print(sum(c));
-  //   print(sum(c, 0));
-  //   print(sum(c, 1));
-  //   print(sum(c, 2));
-  //   print(mean(c));
-  //   print(mean(c, 0));
-  //   print(mean(c, 1));
-  //   print(mean(c, 2));
+  auto c = np::ones({2, 3, 4});
+  print(sum(c));
+  print(sum(c, 0));
+  print(sum(c, 1));
+  print(sum(c, 2));
+  print(mean(c));
+  print(mean(c, 0));
+  print(mean(c, 1));
+  print(mean(c, 2));
+  print(sum(c, {0, 2}), sum(c.T(), 0, true).shape());
+  print(mean(c, {-1, 1}, true));
+  print(np::add.reduce(c));
+
+  // compensated summation keeps what pairwise summation loses to cancellation
+  auto d = np::ndarray<np::float_>({1e16, 1.0, -1e16, 1.0}, {4});
+  print(np::sum(d), np::sum(d, np::summation::neumaier));
+
+  // large reductions give the same result for any number of threads
+  auto e = np::arange<np::float_>(1 << 21) / 3.0;
+  print(np::sum(e, np::summation::pairwise, 1) == np::sum(e, np::summation::pairwise, 4));
+  print(np::max(e, python::None, 4), np::min(e, python::None, 4));
+
+  // maxima, minima and their indices, NaN-aware or not
+  auto f = np::ndarray<np::float_>({1, 5, NAN, 5, 3, NAN}, {2, 3});
+  print(np::max(f), np::nanmax(f), np::argmax(f), np::nanargmax(f), np::nanargmin(f));
+  print(np::amax(f, 0), np::argmax(f, 1), np::nanmax(f, 1, true));
+  print(np::max(f, 1), np::min(f, 0));
+  auto f2 = np::ndarray<np::float_>({1, 5, 2, 7, 3, 0}, {2, 3});
+  print(np::nanmax(f2, 1), np::nanmin(f2, 0), np::nanmax(f2, python::None, 4));
+  print(np::argmin(np::arange<np::float_>(300) - 150.0, 0), np::argmax(np::arange<np::float_>(300).reshape({3, 100}), 1));
+
+  // moments in one pass, accurate about a large mean
+  auto g = np::ndarray<np::float_>({1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16}, {2, 2});
+  print(np::var(g), np::std(g, python::None, 1), np::var(g, 0), np::std(g, 1, 0, true));
+  print(np::ptp(g), np::ptp(g, 1), np::average(g, 0, np::ndarray<np::float_>({3, 1}, {2})));
+  auto h = np::ndarray<np::float_>({0, 1, 2, 2, 1, 0, 1, 3, 5}, {3, 3});
+  print(np::cov(h), np::corrcoef(h, false));
+
+  // sorting, NaNs last, by radix and parallel merges for large arrays, and selection
+  print(np::sort(f), np::argsort(f, 0), np::sort(f, python::None));
+  auto s = np::sort(-e, -1, 4);
+  print(s[0], s[s.size() - 1], np::argsort(-e)[0]);
+  auto k = np::ndarray<np::float_>({7, 2, 9, 4, 1, 8}, {6});
+  print(np::partition(k, 2)[2], np::argpartition(k, {0, -1}));
   } catch(const std::exception& e) {
     print(e);
   }
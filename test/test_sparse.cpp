@@ -0,0 +1,64 @@
+#include <numpy/python.hpp>
+#include <numpy/numpy.hpp>
+#include <scipy/linalg/linalg.hpp>
+
+using namespace python;
+namespace np = numpy;
+
+int main() {
+  // COO with a duplicate entry, which is summed
+  auto data = np::ndarray<np::float_>({4, -1, -1, 4, -1, -1, 3, 1}, {8});
+  auto row = np::ndarray<int>({0, 0, 1, 1, 1, 2, 2, 2}, {8});
+  auto col = np::ndarray<int>({0, 1, 0, 1, 2, 1, 2, 2}, {8});
+  auto coo = scipy::sparse::coo_matrix(data, row, col, {3, 3});
+  print(coo.toarray());
+
+  // conversions
+  auto csr = coo.tocsr();
+  print(csr.data, csr.indices, csr.indptr);
+  auto csc = csr.tocsc();
+  print(csc.data, csc.indices, csc.indptr);
+  print(csc.tocsr().toarray());
+  print(scipy::sparse::csr_matrix(csr.toarray()).indptr);
+  print(csr.diagonal());
+
+  // compressed arrays given by the user are checked
+  try {
+    scipy::sparse::csr_matrix<np::float_>(np::ndarray<np::float_>({1, 2}, {2}), np::ndarray<int>({0, 3}, {2}),
+					  np::ndarray<np::intp>({0, 1, 2}, {3}), {2, 3});
+  } catch (const std::exception& e) {
+    print(e);
+  }
+  try {
+    scipy::sparse::csc_matrix<np::float_>(np::ndarray<np::float_>({1, 2}, {2}), np::ndarray<int>({0, 1}, {2}),
+					  np::ndarray<np::intp>({0, 2, 1, 2}, {4}), {2, 3});
+  } catch (const std::exception& e) {
+    print(e);
+  }
+
+  // products with dense vectors and matrices
+  auto x = np::ndarray<np::float_>({1, 2, 3}, {3});
+  print(csr.dot(x));
+  print(csc.dot(x));
+  print(csr.dot(np::identity(3)));
+
+  // iterative solvers
+  auto b = np::ndarray<np::float_>({2, 0, 6}, {3});
+  print(scipy::linalg::cg(csr, b));
+  print(scipy::linalg::_solve::Jacobi(csr, b).solve());
+  print(scipy::linalg::_solve::SOR(csc, b, 1.1).solve());
+  print(scipy::linalg::_solve::Gauss_Seidel(csr, b, scipy::linalg::eps_default, true).solve()); // multicolor, all CPUs
+
+  // preconditioned conjugate gradient
+  print(scipy::linalg::cg(csr, b, scipy::linalg::eps_default, 0, scipy::linalg::jacobi_preconditioner(csr)));
+  print(scipy::linalg::cg(csr, b, scipy::linalg::eps_default, 0, scipy::linalg::ssor_preconditioner(csr, 1.2)));
+  print(scipy::linalg::cg(csr, b, scipy::linalg::eps_default, 0, scipy::linalg::ichol0_preconditioner(csr)));
+
+  // unsorted rows with a duplicate entry are sorted and summed, as the preconditioners expect
+  auto u = scipy::sparse::csr_matrix<np::float_>(np::ndarray<np::float_>({-1, 4, 2, -1, -1, 2, 3, -1, 1}, {9}),
+						 np::ndarray<int>({1, 0, 1, 0, 2, 1, 2, 1, 2}, {9}),
+						 np::ndarray<np::intp>({0, 2, 6, 9}, {4}), {3, 3});
+  print(u.indices, u.indptr);
+  print(scipy::linalg::cg(u, b, scipy::linalg::eps_default, 0, scipy::linalg::ichol0_preconditioner(u)));
+  print(scipy::linalg::cg(u, b, scipy::linalg::eps_default, 0, scipy::linalg::ssor_preconditioner(u, 1.2)));
+}